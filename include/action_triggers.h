@@ -0,0 +1,72 @@
+#pragma once
+#include "compact_plan.h"
+#include "spatial_grid.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Position-Triggered Mechanism Actions
+ *
+ * Played by time, an action happens when the clock reaches its frame, which
+ * is in the wrong place whenever the robot runs late or early. Here every
+ * mechanism event of the plan (a piston toggle, or the intake/outtake power
+ * changing) is anchored to the pose it was recorded at and fires when the
+ * robot comes within the trigger radius of it.
+ *
+ * - An event is armed from `window` before its frame's time, so a robot
+ *   crossing the same spot earlier in the route doesn't set it off
+ * - If the robot never gets close, it fires anyway `window` after its time
+ * - Events fire in recorded order: reaching one fires every earlier event
+ *   that hasn't fired yet, so toggles keep their parity and powers end up
+ *   as the latest event left them
+ *
+ * Event positions go into a SpatialGrid (cells one trigger radius across),
+ * so each tick only looks at the events in the 3x3 cells around the robot.
+ */
+
+// One mechanism event along the plan
+struct PlanEvent {
+    uint32_t frame;         // Plan frame it was recorded at
+    float x;                // Where (inches)
+    float y;
+    int8_t intakePower;     // Powers from this event on
+    int8_t outtakePower;
+    uint8_t toggles;        // BTN_X/A/B pistons to flip
+};
+
+class ActionTriggers {
+private:
+    std::vector<PlanEvent> events;
+    float radius = 3.0f;
+
+    SpatialGrid grid;               // Event positions (point i is events[i])
+
+    size_t nextEvent = 0;           // First event that hasn't fired
+
+public:
+    /**
+     * Find the plan's events and index them
+     * @param radius Trigger radius (inches); also the grid's cell size
+     */
+    void build(const CompactPlan& plan, float radius);
+
+    /**
+     * Re-arm every event for a new run
+     */
+    void reset() { nextEvent = 0; }
+
+    /**
+     * Find the events that fire this tick
+     * @param x, y The robot's position
+     * @param timeFrame Plan frame the clock is at
+     * @param windowFrames Arming/fallback window in plan frames
+     * @return one past the last event that fired; events
+     *         [previous return value, this one) fired this tick
+     */
+    size_t update(float x, float y, size_t timeFrame, size_t windowFrames);
+
+    const PlanEvent& operator[](size_t i) const { return events[i]; }
+    size_t size() const { return events.size(); }
+    size_t fired() const { return nextEvent; }
+};
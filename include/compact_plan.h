@@ -0,0 +1,163 @@
+#pragma once
+#include "recording_format.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+/**
+ * Quantized Playback Plan
+ *
+ * A plan is held for as long as it may be played, and a long recording on a
+ * 10 ms grid runs to tens of thousands of frames. Each one is kept in 13
+ * bytes (9 of pose and mechanisms, 4 of derived motion) instead of
+ * GridFrame's 16 and decoded when the playback loop reads it. There is no
+ * timestamp: plan frame k plays at k * grid period.
+ *
+ * Precision (rounding to the nearest step):
+ * - x/y: 0.01 in steps from the centre of the plan's path, so within
+ *   0.005 in of the resampled pose for any path up to 655 in across (the
+ *   field is 144 in; farther points are clamped)
+ * - theta: 360/65536 deg steps, within 0.003 deg. The heading comes back
+ *   wrapped to [-180, 180); whole turns are dropped, which the controller
+ *   doesn't see since it wraps every heading error.
+ * - Motor powers, toggles and the action flag are kept exactly
+ *
+ * Per-frame motion (path speed and turn rate) is derived once, from the
+ * full-precision frames, when the plan is built; playback only looks it up.
+ * Differencing the quantized poses instead would be too noisy to feed
+ * forward (0.01 in over a 10 ms frame is 1 in/s). See plan_cache.h for keeping a built plan on the card.
+ *
+ * A load transform (mirror/rotate/translate) doesn't touch the stored
+ * frames: it is kept as a PlanPlacement and applied to each frame as it's
+ * decoded. That lets a plan linked into the program (readInPlace()) be
+ * played straight from read-only memory, on either side of the field.
+ */
+
+#pragma pack(push, 1)
+struct PlanFrame {
+    int16_t x;              // 0.01 in from the plan origin
+    int16_t y;
+    int16_t theta;          // 360/65536 deg
+    int8_t intakePower;
+    int8_t outtakePower;
+    uint8_t flags;          // GridFrame::toggles (BTN_X/A/B bits) | PLAN_ACTION_BIT
+};
+#pragma pack(pop)
+
+// Motion along the plan at a frame (derived, not recorded)
+#pragma pack(push, 1)
+struct PlanMotion {
+    int16_t speed;          // PLAN_SPEED_STEP units along the heading, negative when reversing
+    int16_t turnRate;       // PLAN_TURN_STEP units, clockwise positive
+};
+#pragma pack(pop)
+
+constexpr uint8_t PLAN_ACTION_BIT = 7;
+constexpr float PLAN_POSITION_STEP = 0.01f;             // Inches per unit
+constexpr float PLAN_ANGLE_STEP = 360.0f / 65536.0f;    // Degrees per unit
+constexpr float PLAN_SPEED_STEP = 0.01f;                // in/s per unit
+constexpr float PLAN_TURN_STEP = 0.1f;                  // deg/s per unit
+
+/**
+ * Rigid move of a plan on the field (LemLib angles: degrees, 0 = +Y,
+ * clockwise positive)
+ */
+struct PlanPlacement {
+    float xx = 1, xy = 0;       // x' = xx * x + xy * y + dx
+    float yx = 0, yy = 1;       // y' = yx * x + yy * y + dy
+    float dx = 0, dy = 0;
+    bool mirrored = false;      // theta' = (mirrored ? -theta : theta) + headingOffset
+    float headingOffset = 0;
+
+    void apply(float& x, float& y, float& theta) const;
+
+    /**
+     * This placement followed by `next`
+     */
+    PlanPlacement then(const PlanPlacement& next) const;
+};
+
+/**
+ * Plan frames in quantized form with the origin they're relative to
+ * The frames are either owned or read in place from memory that outlives
+ * the plan (readInPlace()); moving a plan keeps them where they are.
+ */
+class CompactPlan {
+private:
+    std::vector<PlanFrame> ownedFrames;
+    std::vector<PlanMotion> ownedMotion;
+    const PlanFrame* frames = nullptr;      // ownedFrames, or read in place
+    const PlanMotion* motion = nullptr;
+    size_t count = 0;
+    float originX = 0;
+    float originY = 0;
+    uint32_t periodUs = 10000;
+    PlanPlacement placement;
+    bool placed = false;                    // placement isn't the identity
+
+    void encodeFrames(const std::vector<GridFrame>& source);
+    void deriveMotion(const std::vector<GridFrame>& source);
+    void useOwned();
+
+public:
+    CompactPlan() = default;
+    CompactPlan(CompactPlan&&) = default;
+    CompactPlan& operator=(CompactPlan&&) = default;
+    CompactPlan(const CompactPlan&) = delete;   // Frames would point into the original
+    CompactPlan& operator=(const CompactPlan&) = delete;
+
+    /**
+     * Replace the contents with `source`, quantized (the origin is the centre
+     * of its bounding box), and derive the motion along it
+     * @param periodUs The grid period `source` was resampled with
+     */
+    void encode(const std::vector<GridFrame>& source, uint32_t periodUs);
+
+    /**
+     * Move the plan on the field, after any earlier placement. Only the
+     * placement changes; frames are moved as they're decoded. Speeds don't
+     * change under a rigid move, and a mirror reverses turning.
+     */
+    void place(const PlanPlacement& next);
+
+    GridFrame operator[](size_t i) const;
+    GridFrame back() const { return (*this)[count - 1]; }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    /**
+     * RAM held by the frames (0 when they're read in place)
+     */
+    size_t bytes() const {
+        return ownedFrames.size() * sizeof(PlanFrame) + ownedMotion.size() * sizeof(PlanMotion);
+    }
+    bool isInPlace() const { return count > 0 && ownedFrames.empty(); }
+    uint32_t getPeriod() const { return periodUs; }
+
+    float speed(size_t i) const { return motion[i].speed * PLAN_SPEED_STEP; }
+    float turnRate(size_t i) const {
+        float rate = motion[i].turnRate * PLAN_TURN_STEP;
+        return placement.mirrored ? -rate : rate;
+    }
+
+    void clear();
+
+    /**
+     * Write/read the plan in its stored form, folding the bytes into `crc`.
+     * The stored form is the plan as built, before any placement.
+     * @param maxFrames Plans longer than this are rejected
+     * @return false on an I/O error or a bad size (`*this` unchanged)
+     */
+    bool write(FILE* file, uint32_t& crc) const;
+    bool read(FILE* file, size_t maxFrames, uint32_t& crc);
+
+    /**
+     * Point the plan at the stored form in memory without copying it (the
+     * memory must outlive the plan, e.g. a linked asset). `data` is advanced
+     * past the plan.
+     * @return false if it runs past `end` or has a bad size (`*this` unchanged)
+     */
+    bool readInPlace(const uint8_t*& data, const uint8_t* end, size_t maxFrames,
+                     uint32_t& crc);
+};
@@ -0,0 +1,12 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * CRC-32 (IEEE 802.3, reflected polynomial 0xEDB88320)
+ *
+ * Slice-by-8 implementation used to fingerprint and integrity-check
+ * recordings. Pass the previous result as `crc` to checksum data that
+ * arrives in pieces; start with 0.
+ */
+uint32_t crc32(const void* data, size_t length, uint32_t crc = 0);
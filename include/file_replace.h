@@ -0,0 +1,16 @@
+#pragma once
+#include <string>
+
+/**
+ * Crash-Safe File Replacement
+ *
+ * Files the brain rewrites (recordings, plan caches) are written to a temp
+ * file first and only then moved over the old one, so a brown-out or card
+ * pull mid-write always leaves one complete file. Kept free of PROS so host
+ * tools write the same way.
+ */
+
+/**
+ * Move a fully written temp file over the target
+ */
+bool replaceFile(const std::string& from, const std::string& to);
@@ -0,0 +1,181 @@
+#pragma once
+#include "recording_format.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Chunked Frame Storage
+ *
+ * The capture buffer used to be a std::vector: once it outgrew its
+ * reservation, push_back() reallocated and copied every frame so far from
+ * inside the driver loop. Frames now go into fixed-size chunks taken from a
+ * pool that is allocated statically, so appending is constant time, never
+ * touches the heap and never moves a frame that's already stored.
+ *
+ * Frames are held quantized, 10 bytes each instead of WaypointFrame's 24,
+ * and widened back to WaypointFrames only when read: the iterator hands them
+ * to the resampler and the SD writer in order.
+ *
+ * Precision (rounding to the nearest step):
+ * - x/y: 0.01 in steps from the previous frame's rounded position, so
+ *   within 0.005 in of the odometry pose however far the path goes (a jump
+ *   of over 327 in between two frames is clamped and caught up after)
+ * - theta: 360/65536 deg steps, within 0.003 deg. The heading comes back
+ *   wrapped to [-180, 180); the resampler interpolates across the wrap.
+ * - timestamp: 10 us steps from the previous frame, within 5 us. Like x/y
+ *   the deltas are between rounded values, so rounding doesn't add up over
+ *   the recording. A gap longer than a 16-bit delta (655 ms)
+ *   is bridged with copies of the frame that ends it.
+ * - Motor powers and buttons are kept exactly; hasAction is derived from
+ *   them again (isActionFrame()), as it was when the frame was recorded
+ *
+ * Buttons change a few times a second at most, so instead of a byte per
+ * frame they go in a change log kept in chunks from the same pool.
+ */
+
+#pragma pack(push, 1)
+struct CaptureFrame {
+    int16_t dx;             // 0.01 in since the previous frame
+    int16_t dy;
+    int16_t theta;          // 360/65536 deg
+    uint16_t dt;            // 10 us steps since the previous frame
+    int8_t intakePower;
+    int8_t outtakePower;
+};
+
+// Buttons from `frame` on (WaypointFrame::buttons)
+struct ButtonChange {
+    uint16_t frame;
+    uint8_t buttons;
+};
+#pragma pack(pop)
+
+constexpr float CAPTURE_POSITION_STEP = 0.01f;            // Inches per unit
+constexpr float CAPTURE_ANGLE_STEP = 360.0f / 65536.0f;   // Degrees per unit
+constexpr uint32_t CAPTURE_TIME_STEP_US = 10;              // Microseconds per dt unit
+
+constexpr size_t FRAME_CHUNK_SIZE = 256;   // Frames per chunk (2.5 KB)
+constexpr size_t BUTTON_CHUNK_SIZE = FRAME_CHUNK_SIZE * sizeof(CaptureFrame) / sizeof(ButtonChange);
+constexpr size_t FRAME_POOL_CHUNKS = 31;   // 77.5 KB: 29 of frames (7424, ~3 min at 25 ms) and 2 of button changes
+constexpr size_t BUTTON_LOG_CHUNKS = 2;    // Chunks of the pool the button log may take
+static_assert(FRAME_CHUNK_SIZE * FRAME_POOL_CHUNKS <= UINT16_MAX, "frame index must fit ButtonChange::frame");
+
+// One pool chunk: frames, or button changes
+union FrameChunk {
+    CaptureFrame frames[FRAME_CHUNK_SIZE];
+    ButtonChange changes[BUTTON_CHUNK_SIZE];
+};
+
+/**
+ * Fixed pool of frame chunks
+ * Chunks are handed out and returned by the owner of the capture buffer only
+ * (not thread-safe).
+ */
+class FramePool {
+private:
+    FrameChunk* chunks;
+    std::array<uint8_t, FRAME_POOL_CHUNKS> freeList;   // Indices of free chunks
+    size_t freeCount = FRAME_POOL_CHUNKS;
+
+public:
+    explicit FramePool(FrameChunk* arena);
+
+    /**
+     * @return a free chunk, or nullptr if all are in use
+     */
+    FrameChunk* acquire();
+
+    void release(FrameChunk* chunk);
+
+    size_t available() const { return freeCount; }
+};
+
+// Global pool, backed by a static arena
+extern FramePool framePool;
+
+/**
+ * Append-only frame buffer made of pool chunks
+ * Move-only: moving hands the chunks over without copying frames.
+ */
+class FrameStore {
+private:
+    FramePool* pool;
+    std::array<FrameChunk*, FRAME_POOL_CHUNKS> chunks = {};
+    std::array<FrameChunk*, BUTTON_LOG_CHUNKS> buttonChunks = {};
+    size_t count = 0;
+    size_t changeCount = 0;
+
+    // Last frame appended, in quantization units
+    int32_t lastX = 0;
+    int32_t lastY = 0;
+    uint64_t lastTime = 0;
+    uint8_t lastButtons = 0;
+
+    const CaptureFrame& frame(size_t i) const {
+        return chunks[i / FRAME_CHUNK_SIZE]->frames[i % FRAME_CHUNK_SIZE];
+    }
+    const ButtonChange& change(size_t i) const {
+        return buttonChunks[i / BUTTON_CHUNK_SIZE]->changes[i % BUTTON_CHUNK_SIZE];
+    }
+    bool append(const CaptureFrame& frame);
+
+public:
+    /**
+     * Forward iterator that widens each frame back to a WaypointFrame
+     * (by value: frames are decoded as they're read)
+     */
+    class Iterator {
+    private:
+        const FrameStore* store;
+        size_t index;
+        int32_t x = 0;              // Current frame in quantization units
+        int32_t y = 0;
+        uint64_t time = 0;
+        uint8_t buttons = 0;        // At the current and previous frame
+        uint8_t prevButtons = 0;
+        size_t nextChange = 0;
+
+        void load();
+
+    public:
+        Iterator(const FrameStore* store, size_t index);
+        WaypointFrame operator*() const;
+        Iterator& operator++() {
+            index++;
+            load();
+            return *this;
+        }
+        bool operator!=(const Iterator& other) const { return index != other.index; }
+    };
+
+    explicit FrameStore(FramePool& pool = framePool) : pool(&pool) {}
+    FrameStore(FrameStore&& other);
+    FrameStore& operator=(FrameStore&& other);
+    FrameStore(const FrameStore&) = delete;
+    FrameStore& operator=(const FrameStore&) = delete;
+    ~FrameStore() { clear(); }
+
+    /**
+     * Quantize and append a frame (takes a new chunk from the pool every
+     * FRAME_CHUNK_SIZE frames). Timestamps must not go backwards.
+     * @return false if the pool is out of chunks; the frame is not stored
+     */
+    bool push_back(const WaypointFrame& frame);
+
+    /**
+     * Return every chunk to the pool
+     */
+    void clear();
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    /**
+     * Timestamp of the last frame (microseconds)
+     */
+    uint64_t duration() const { return lastTime * CAPTURE_TIME_STEP_US; }
+
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, count); }
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include "recording_format.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * Idle Trimming
+ *
+ * Recordings carry dead time: the wait after the countdown before the
+ * driver moves, pauses while they think, and the tail before DOWN is
+ * pressed. Playback reproduces all of it. This finds stationary stretches
+ * of a plan and shortens each one to a minimum dwell; the frames after it
+ * move up, which re-times them since plan frame k plays at k * period.
+ *
+ * A plan frame is idle when the robot is barely moving (speed and turn rate
+ * below the thresholds), it stays close to where the stretch began, no
+ * piston toggles or action happens, and the intake and outtake are stopped.
+ * Pauses with a roller running are kept: they are usually waiting for a
+ * game piece.
+ */
+
+struct IdleTrimConfig {
+    float maxSpeed = 1.0f;          // in/s
+    float maxTurnRate = 10.0f;      // deg/s
+    float maxDrift = 0.5f;          // Inches from the start of the stretch
+    float maxHeadingDrift = 2.0f;   // Degrees from the start of the stretch
+    uint32_t minDwellMs = 300;      // Each idle stretch keeps this much
+};
+
+struct IdleTrimReport {
+    uint32_t intervals = 0;         // Idle stretches shortened
+    uint32_t removedFrames = 0;
+    float secondsSaved = 0;
+};
+
+/**
+ * Shorten every idle stretch of a plan in place
+ * @param periodUs The plan's grid period
+ */
+IdleTrimReport trimIdle(std::vector<GridFrame>& plan, uint32_t periodUs,
+                        const IdleTrimConfig& config = IdleTrimConfig());
@@ -0,0 +1,42 @@
+#pragma once
+#include "main.h"
+#include <cstdint>
+
+/**
+ * Control Loop Timer
+ *
+ * Keeps a loop on a fixed cadence with pros::Task::delay_until() and
+ * measures how well it holds it, so stalls (SD writes, screen redraws,
+ * blocking calls) show up as numbers instead of a feeling.
+ */
+
+struct LoopStats {
+    float avgPeriodMs = 0;      // Smoothed iteration period
+    uint32_t maxPeriodUs = 0;   // Longest iteration since the last reset
+    uint32_t lateIterations = 0; // Iterations over 1.5x the target period
+    uint32_t iterations = 0;    // Since the last reset
+};
+
+/**
+ * Fixed-period loop pacing and timing stats
+ */
+class LoopTimer {
+private:
+    uint32_t periodMs;
+    uint32_t nextWake = 0;      // pros::millis() deadline for delay_until
+    uint64_t lastWake = 0;      // pros::micros() the previous wait() returned
+    LoopStats stats;
+
+public:
+    explicit LoopTimer(uint32_t periodMs = 20) : periodMs(periodMs) {}
+
+    /**
+     * Sleep until the next period boundary and record the iteration
+     * Call once at the end of every loop iteration
+     */
+    void wait();
+
+    void resetStats() { stats = LoopStats(); }
+    const LoopStats& getStats() const { return stats; }
+    uint32_t getPeriod() const { return periodMs; }
+};
@@ -0,0 +1,118 @@
+#pragma once
+#include "lemlib/api.hpp" // IWYU pragma: keep
+#include "main.h"         // IWYU pragma: keep
+#include <functional>
+#include <vector>
+
+/**
+ * Chained Motion Executor
+ *
+ * Runs a list of waypoints through lemlib::Chassis::moveToPoint() without
+ * stopping at every point. Each motion is started async so LemLib queues the
+ * next one (motionQueued) while the current one is still running; minSpeed and
+ * earlyExitRange let the current motion hand over to the queued one at speed.
+ */
+
+// Single point in a chained route
+struct ChainWaypoint {
+    float x;                 // Target X in inches
+    float y;                 // Target Y in inches
+    float maxSpeed = 127;    // Speed cap for the motion into this point (0-127)
+    bool forwards = true;    // Drive direction for the motion into this point
+    int timeout = 3000;      // Motion timeout in ms
+
+    // Mechanism action to run once the robot has settled on this point.
+    // Points with an action always come to a full stop for endpoint accuracy.
+    std::function<void()> action = nullptr;
+};
+
+/**
+ * Blends consecutive moveToPoint() motions using a per-waypoint carry speed
+ */
+class MotionChain {
+private:
+    std::vector<ChainWaypoint> waypoints;
+
+    // Configuration
+    float maxCarrySpeed = 90.0f;    // Carry speed through a straight (0 deg) pass-through
+    float minCarrySpeed = 20.0f;    // Below this the motion just stops instead
+    float stopTurnAngle = 120.0f;   // Degrees - sharper turns than this stop fully
+    float maxExitRange = 6.0f;      // Inches - earlyExitRange at maxCarrySpeed
+    float minExitRange = 1.0f;      // Inches - earlyExitRange floor for carried points
+
+    // Pose the current run started from (previous point of the first motion)
+    lemlib::Pose runStart = lemlib::Pose(0, 0, 0);
+
+    // Where the loaded path expects the robot to start (jerryio paths only)
+    lemlib::Pose pathStart = lemlib::Pose(0, 0, 0);
+    bool hasPathStart = false;
+
+    // Duration of the last run (ms)
+    uint32_t lastRunTime = 0;
+
+    // Helper methods
+    float turnAngleAt(size_t index) const;
+    float computeCarrySpeed(size_t index) const;
+    float computeExitRange(float carrySpeed) const;
+
+public:
+    // ==================== Route Building ====================
+
+    /**
+     * Append a waypoint to the end of the route
+     */
+    void addWaypoint(const ChainWaypoint& waypoint);
+    void addWaypoint(float x, float y, float maxSpeed = 127, bool forwards = true);
+
+    /**
+     * Attach a mechanism action to the most recently added waypoint
+     */
+    void addAction(std::function<void()> action);
+
+    /**
+     * Load the route from a static path asset made of
+     * "moveToPoint(x, y, theta, speed);" lines (e.g. static/skills.txt).
+     * x and y are the target and speed (0-127, optional) its maxSpeed; theta
+     * is ignored. A jerryio export is converted from its unit of length
+     * (the "uol" in its #PATH.JERRYIO-DATA line) to inches, and its first
+     * control point becomes the start pose. Other files are read as inches.
+     */
+    bool loadPath(const asset& path);
+
+    /**
+     * Start pose of the loaded path
+     * @return false if the path didn't say (not a jerryio export)
+     */
+    bool getStartPose(lemlib::Pose& pose) const {
+        pose = pathStart;
+        return hasPathStart;
+    }
+
+    /**
+     * Remove every waypoint
+     */
+    void clear();
+
+    // ==================== Execution ====================
+
+    /**
+     * Run the whole route, blocking until the last motion finishes.
+     * Starting pose is whatever odometry currently reports.
+     */
+    void run();
+
+    // ==================== Getters/Setters ====================
+
+    size_t size() const { return waypoints.size(); }
+    uint32_t getLastRunTime() const { return lastRunTime; }
+
+    void setCarrySpeedRange(float minSpeed, float maxSpeed) {
+        minCarrySpeed = minSpeed;
+        maxCarrySpeed = maxSpeed;
+    }
+    void setStopTurnAngle(float degrees) { stopTurnAngle = degrees; }
+    void setExitRange(float minInches, float maxInches) {
+        minExitRange = minInches;
+        maxExitRange = maxInches;
+    }
+};
@@ -0,0 +1,131 @@
+#pragma once
+#include "compact_plan.h"
+#include "replay_controller.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Short-Horizon MPC Tracking Controller
+ *
+ * The plan is known before the run starts. So rather than reacting to the
+ * current target, this looks at the next N plan frames and picks the
+ * left/right power sequence that follows them best. Only the first step of
+ * that sequence is applied:
+ *   - model: differential drive with a first-order motor lag (state x, y,
+ *     heading, left/right wheel speed), linearized about where last tick's
+ *     power sequence takes the robot from its measured pose. One model step
+ *     is one playback tick as measured by the caller, not a nominal 20 ms:
+ *     the loop sleeps 20 ms after its work, so a tick is always longer
+ *   - cost: squared pose and wheel speed error against the plan over the
+ *     horizon, plus squared deviation from the plan's own feedforward power
+ *   - constraint: power within -127..127 on both sides
+ *
+ * The problem is condensed to corrections of the 2N powers and solved by
+ * accelerated projected gradient for a fixed number of iterations (one
+ * linearization per tick, so each tick refines the last tick's solution). The work per tick depends only on N and the
+ * iteration budget, never on the data, so a horizon that fits the tick once
+ * always fits it (tools/mpc_horizon_bench.cpp measures it). Every matrix is
+ * a fixed-size member sized for MAX_HORIZON; nothing is allocated while
+ * running.
+ *
+ * No PROS dependency, so the simulator in tools/ runs the same code.
+ */
+
+struct MpcGains {
+    uint32_t horizon = 10;          // Steps looked ahead (1..MpcController::MAX_HORIZON)
+    uint32_t iterations = 20;       // Solver iterations per tick
+    float positionWeight = 1.0f;    // Per in^2 of position error
+    float headingWeight = 100.0f;   // Per rad^2 of heading error
+    float speedWeight = 0.001f;     // Per (in/s)^2 of wheel speed error
+    float inputWeight = 0.5f;       // Per (full power)^2 away from the feedforward
+    float observerGain = 0.5f;      // Wheel speeds: 0 = model only, 1 = measured pose change only
+    float maxSpeed = 76.6f;         // in/s at full power (450 rpm, 3.25" omnis)
+    float trackWidth = 11.5f;       // Inches
+    float timeConstant = 0.08f;     // s, motor + chassis response
+};
+
+class MpcController {
+public:
+    static constexpr size_t MAX_HORIZON = 30;
+    static constexpr size_t STATES = 5;     // x, y, heading, left speed, right speed
+    static constexpr size_t INPUTS = 2;     // Left, right power (-1..1)
+
+private:
+    static constexpr size_t MAX_VARS = MAX_HORIZON * INPUTS;
+
+    using StateMatrix = std::array<float, STATES * STATES>;
+    using InputMatrix = std::array<float, STATES * INPUTS>;
+    using Horizon = std::array<float, MAX_HORIZON + 1>;
+    using Vars = std::array<float, MAX_VARS>;
+
+    MpcGains gains;
+    float dt = 0.02f;                   // s, model step (the last tick passed in)
+
+    // Plan along the horizon, steps 0..N (heading counter-clockwise from +X)
+    Horizon refX, refY, refPhi, refSpeed, refLeft, refRight;
+    Vars feedforward;                   // Power that keeps the model on the plan
+
+    // Nominal powers and the trajectory they give from the measured pose,
+    // stored as the error to the plan at steps 0..N
+    Vars nominal;
+    std::array<float, (MAX_HORIZON + 1) * STATES> nominalError;
+
+    // Model linearized about that trajectory: d[k+1] = A[k] d[k] + B du[k]
+    std::array<StateMatrix, MAX_HORIZON> dynamics;
+    InputMatrix input;
+
+    // Effect of du[j] on d[i] (i > j), lower triangle by rows
+    std::array<InputMatrix, MAX_HORIZON * (MAX_HORIZON + 1) / 2> response;
+
+    // Condensed QP: minimise du'H du / 2 + f'du within [lower, upper]
+    std::array<float, MAX_VARS * MAX_VARS> hessian;
+    Vars linear, lower, upper;
+    Vars solution, momentum, projected;
+    Vars previous;                      // Last tick's powers (next tick's nominal)
+    bool warm = false;
+
+    // Wheel speeds (in/s): odometry only gives the pose, so they are
+    // predicted from the commands and corrected by how far the pose moved
+    float leftSpeed = 0;
+    float rightSpeed = 0;
+    float lastX = 0;
+    float lastY = 0;
+    float lastPhi = 0;
+    bool hasPose = false;
+
+    void observe(float x, float y, float phi);
+
+    size_t steps() const;
+    void buildReference(const CompactPlan& plan, size_t frame, size_t n);
+    void rollout(float x, float y, float phi, size_t n);
+    void condense(size_t n);
+    void solve(size_t n);
+
+public:
+    explicit MpcController(const MpcGains& gains = MpcGains()) : gains(gains) {}
+
+    /**
+     * Forget everything - call before every run (the robot starts stopped)
+     */
+    void reset();
+
+    /**
+     * Drop the warm start but keep the modeled wheel speeds (after the plan
+     * position jumps, e.g. a re-sync)
+     */
+    void restart() { warm = false; }
+
+    /**
+     * Command that best follows the plan from `frame` onwards
+     * @param periodMs Measured playback loop period (ms) - the model step
+     */
+    DriveCommand update(const CompactPlan& plan, size_t frame, float x, float y, float theta,
+                        float periodMs);
+
+    void setGains(const MpcGains& newGains) {
+        gains = newGains;
+        warm = false;
+    }
+    const MpcGains& getGains() const { return gains; }
+};
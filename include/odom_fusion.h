@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * Fused Odometry Estimator
+ *
+ * Complementary filter combining the vertical tracking wheel, the drive
+ * motor encoders and the IMU. Heading comes mostly from the IMU with the
+ * encoder heading filling in its high-frequency noise; forward travel blends
+ * the tracking wheel (ground truth when it's down) with the drive encoders
+ * (never bounce). A one-step disagreement is treated as a wheel bounce (use
+ * the drive); a sustained one as drive slip (use the wheel, undoing the
+ * first step).
+ *
+ * Pure math with no PROS dependency, so it can be benchmarked on a host
+ * (see tools/odom_fusion_bench.cpp). Angles follow LemLib's convention:
+ * degrees, 0 = +Y, clockwise positive.
+ */
+
+// One set of cumulative sensor readings
+struct OdomFusionInput {
+    float verticalWheel;    // Tracking wheel distance (inches, cumulative)
+    float leftDrive;        // Left drive encoder distance (inches, cumulative)
+    float rightDrive;       // Right drive encoder distance (inches, cumulative)
+    float imuRotation;      // IMU rotation (degrees, unbounded); NaN if unavailable
+    float dt;               // Seconds since the previous step
+};
+
+// Estimated pose and velocity
+struct FusedPose {
+    float x = 0;            // Inches
+    float y = 0;
+    float theta = 0;        // Degrees
+};
+
+struct OdomFusionConfig {
+    float trackWidth = 11.5f;       // Inches between left and right drive wheels
+    float wheelOffset = -0.25f;     // Tracking wheel offset from tracking center (inches)
+    float imuWeight = 0.98f;        // Share of heading change taken from the IMU
+    float wheelWeight = 0.8f;       // Share of forward travel taken from the tracking wheel
+    float slipThreshold = 0.15f;    // Inches per step of wheel/drive disagreement treated as slip
+};
+
+/**
+ * Complementary filter over wheel, drive encoders and IMU
+ */
+class OdomFusion {
+private:
+    OdomFusionConfig config;
+    FusedPose pose;
+
+    // Velocity in the global frame (inches/sec, degrees/sec)
+    float speedX = 0;
+    float speedY = 0;
+    float speedTheta = 0;
+
+    // Previous cumulative readings
+    OdomFusionInput prev = {0, 0, 0, 0, 0};
+    bool hasPrev = false;
+
+    uint32_t disagreeSteps = 0;     // Consecutive steps over slipThreshold
+    float pendingExcess = 0;        // Drive travel credited on an unconfirmed bounce
+    uint32_t slipSteps = 0;         // Total steps treated as drive slip
+
+public:
+    explicit OdomFusion(const OdomFusionConfig& config = OdomFusionConfig()) : config(config) {}
+
+    /**
+     * Advance the estimate with a new set of readings
+     */
+    void step(const OdomFusionInput& input);
+
+    /**
+     * Set the pose (sensor references are kept, so no travel is lost)
+     */
+    void setPose(const FusedPose& newPose);
+
+    /**
+     * Start over at a pose: the next step() only takes new sensor references
+     * (after the filter hasn't been stepped for a while)
+     */
+    void restart(const FusedPose& newPose);
+
+    /**
+     * Extrapolate the pose `seconds` ahead using the current velocity
+     */
+    FusedPose predict(float seconds) const;
+
+    FusedPose getPose() const { return pose; }
+    uint32_t getSlipSteps() const { return slipSteps; }
+    void setConfig(const OdomFusionConfig& newConfig) { config = newConfig; }
+};
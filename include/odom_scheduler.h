@@ -0,0 +1,119 @@
+#pragma once
+#include "lemlib/api.hpp" // IWYU pragma: keep
+#include "main.h"         // IWYU pragma: keep
+#include "odom_fusion.h"
+#include <cstdint>
+
+/**
+ * Odometry Scheduler
+ *
+ * Runs lemlib::update() from our own task instead of the fixed 10 ms loop
+ * chassis.calibrate() starts, so the odometry period and priority can be
+ * tuned and the actual update rate / cost can be measured.
+ *
+ * LemLib 0.5 assumes that 10 ms tick: update() divides each pose change by
+ * 0.01 s to get its speed. The pose itself is right at any period, but at
+ * 5 ms lemlib::getSpeed() reads twice the real speed. Predict the LemLib
+ * pose with estimatePose() below, which corrects for the period, rather than
+ * lemlib::estimatePose().
+ */
+
+// Measured odometry timing (written by the odom task, read by anyone)
+struct OdomStats {
+    float rateHz = 0;           // Measured update rate
+    float avgCostUs = 0;        // Smoothed time spent in one tick
+    uint32_t maxCostUs = 0;     // Worst single tick
+    uint32_t maxJitterUs = 0;   // Worst deviation from the configured period
+    uint32_t updates = 0;       // Ticks run since the last reset
+    uint32_t staleTicks = 0;    // Ticks where no sensor had new data (batching only)
+};
+
+// One batched read of the odometry sensors, shared with other consumers
+struct OdomSample {
+    int32_t rotationPosition = 0;   // rotation_sensor position (centidegrees)
+    double imuRotation = 0;         // IMU rotation (degrees, unbounded)
+    uint64_t timestamp = 0;         // pros::micros() when read
+};
+
+/**
+ * Owns the odometry task
+ */
+class OdomScheduler {
+private:
+    pros::Task* task = nullptr;
+
+    // Configuration
+    uint32_t periodMs = 10;                             // Update period (5 ms minimum)
+    uint32_t priority = TASK_PRIORITY_DEFAULT + 1;      // Above the opcontrol loop
+    bool batchSensorReads = false;                      // Read sensors once per tick into a shared sample
+
+    // Optional fused estimate, stepped every tick alongside lemlib::update()
+    bool fusionEnabled = false;
+    OdomFusion fusion;
+
+    // Instrumentation
+    OdomStats stats;
+    OdomSample latestSample;
+    bool resetRequested = false;
+
+    // The odom task writes fusion, stats and latestSample while playback and
+    // the UI read them
+    mutable pros::Mutex mutex;
+
+    void run();
+    void stepFusion(uint64_t now, uint64_t& lastStep);
+
+public:
+    /**
+     * Set up odometry sensors and start the update task
+     * Call this instead of chassis.calibrate() in initializeRobot()
+     */
+    void start();
+
+    // ==================== Configuration ====================
+
+    void setPeriod(uint32_t ms);
+    void setPriority(uint32_t taskPriority);
+    void setSensorBatching(bool enabled) { batchSensorReads = enabled; }
+
+    /**
+     * Run the fused estimate; turning it on starts it at the current LemLib
+     * pose, so it never resumes from a stale one
+     */
+    void setFusionEnabled(bool enabled);
+    void setFusionConfig(const OdomFusionConfig& config);
+
+    // ==================== Pose ====================
+
+    /**
+     * Set the pose of both LemLib odometry and the fused estimate
+     */
+    void setPose(const lemlib::Pose& pose);
+
+    /**
+     * Fused wheel + drive encoder + IMU pose (frozen unless fusion is enabled;
+     * PositionReplay::setPoseSource(PoseSource::Fused) enables it)
+     * @param horizon seconds to extrapolate ahead (0 = current estimate)
+     */
+    lemlib::Pose getFusedPose(float horizon = 0) const;
+
+    /**
+     * LemLib pose extrapolated `horizon` seconds ahead, with LemLib's speed
+     * rescaled from its assumed 10 ms tick to the configured period
+     */
+    lemlib::Pose estimatePose(float horizon) const;
+
+    bool isFusionEnabled() const { return fusionEnabled; }
+    uint32_t getSlipSteps() const;
+
+    // ==================== Instrumentation ====================
+
+    OdomStats getStats() const;
+    OdomSample getLatestSample() const;
+    void resetStats() { resetRequested = true; }
+
+    uint32_t getPeriod() const { return periodMs; }
+};
+
+// Global instance
+extern OdomScheduler odomScheduler;
@@ -0,0 +1,51 @@
+#pragma once
+#include "compact_plan.h"
+#include "spatial_grid.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Nearest-Point Path Index
+ *
+ * Finds the plan frame closest to a position, for rejoining the path after
+ * the robot has been pushed off it. Frame positions are bucketed into a
+ * SpatialGrid; a query searches rings of cells outward from the robot and
+ * stops once no nearer frame can exist. Each cell lists its frames in
+ * order, so restricting the search to a range of frames (a time window
+ * around the clock, so a path that crosses itself doesn't send playback to
+ * the wrong pass) is a binary search per cell.
+ */
+class PathIndex {
+private:
+    const CompactPlan* plan = nullptr;
+    SpatialGrid grid;
+
+public:
+    /**
+     * Index every frame of a plan (the plan must outlive the index and not
+     * change until the next build)
+     * @param cellSize Grid cell size in inches
+     */
+    void build(const CompactPlan& plan, float cellSize = 6.0f);
+
+    /**
+     * Nearest frame to (x, y) among frames [first, last]
+     * @param maxDistance Ignore frames farther than this (inches)
+     * @return false if no frame in the range is within maxDistance
+     */
+    bool nearest(float x, float y, size_t first, size_t last, float maxDistance,
+                 size_t& frame, float& distance) const;
+
+    /**
+     * Frame to re-sync playback to when the robot at (x, y) is off the path
+     * Running behind along the path is normal for a tracking law and is not
+     * a reason: the robot must be more than offPath from every frame in
+     * [first, last] (cross-track), and the nearest of them must be under
+     * half as far as the target the clock is at
+     * @param targetDistance Inches from the robot to the current target
+     * @return false if playback should keep following the clock
+     */
+    bool rejoin(float x, float y, size_t first, size_t last, float offPath,
+                float targetDistance, size_t& frame) const;
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include "compact_plan.h"
+#include "idle_trim.h"
+#include "resampler.h"
+#include <cstdint>
+#include <string>
+
+/**
+ * Playback Plan Cache
+ *
+ * Building a plan means reading every raw frame off the card, checking the
+ * CRC, resampling, trimming and deriving the motion. The result only depends
+ * on the recording and the build settings, so it is written next to the
+ * recording (position_recording.bin -> position_recording.plan) and read
+ * back directly on later loads.
+ *
+ * The cache is keyed by the recording's CRC-32 (the trailer of its file, so
+ * checking the key costs two small reads) and every setting that shapes the
+ * plan. Changing the grid period or the idle trim settings, or re-recording
+ * the slot, makes the cache miss and it is rebuilt on that load. The cache
+ * holds the plan before any load transform (mirror/rotate) is applied.
+ *
+ * The same file, built on the host by tools/embed_plan.cpp, is what a
+ * recording linked into the program is: readPlanInPlace() checks it and
+ * points the plan at the linked bytes, so it's played without a copy.
+ */
+
+constexpr uint32_t PLAN_CACHE_MAGIC = 0x504C414E; // "PLAN"
+constexpr uint32_t PLAN_CACHE_VERSION = 3; // 2: PlanMotion without distance, 3: start info
+
+// What a cached plan was built from
+struct PlanCacheKey {
+    uint32_t recordingChecksum = 0;
+    uint32_t sourceFrames = 0;
+    uint32_t periodUs = 0;
+    uint32_t nominalIntervalUs = 0;     // Only affects the resample report
+    bool trimEnabled = false;
+    IdleTrimConfig trim;
+
+    bool operator==(const PlanCacheKey& other) const;
+};
+
+// The plan plus the reports that were shown when it was built
+struct CachedPlan {
+    CompactPlan plan;
+    RecordingStartInfo start = {0, 0, 0, -1};   // From the recording's file
+    ResampleReport resample;
+    IdleTrimReport trim;
+};
+
+/**
+ * Sidecar path for a recording: the extension becomes .plan
+ */
+std::string planCachePath(const std::string& recordingPath);
+
+/**
+ * Write a plan cache (temp file, CRC-32 trailer, then replace)
+ */
+bool writePlanCache(const std::string& path, const PlanCacheKey& key,
+                    const RecordingStartInfo& start, const CompactPlan& plan,
+                    const ResampleReport& resample, const IdleTrimReport& trim);
+
+/**
+ * Read a plan cache if it was built with exactly `key`
+ * @param maxFrames Plans longer than this are rejected
+ * @return false on a missing file, key mismatch or bad CRC (`out` unchanged)
+ */
+bool readPlanCache(const std::string& path, const PlanCacheKey& key, size_t maxFrames,
+                   CachedPlan& out);
+
+/**
+ * Check a whole plan file held in memory and point `out.plan` at its frames
+ * (not copied; `data` must outlive it). Any key is accepted and returned.
+ * @return false on a bad magic/version, truncated data or CRC mismatch
+ */
+bool readPlanInPlace(const uint8_t* data, size_t size, size_t maxFrames, PlanCacheKey& key,
+                     CachedPlan& out);
@@ -1,5 +1,21 @@
 #pragma once
 #include "main.h"
+#include "lemlib/pose.hpp"
+#include "action_triggers.h"
+#include "compact_plan.h"
+#include "frame_store.h"
+#include "mpc_controller.h"
+#include "path_index.h"
+#include "ramsete_controller.h"
+#include "recording_format.h"
+#include "recording_view.h"
+#include "idle_trim.h"
+#include "plan_cache.h"
+#include "resampler.h"
+#include "replay_controller.h"
+#include "run_log.h"
+#include "tuning_config.h"
+#include <atomic>
 #include <vector>
 #include <string>
 
@@ -10,64 +26,171 @@
  * and replays using pure pursuit with mechanism action pauses.
  */
 
-// Single waypoint frame - captures position and mechanism states at a moment in time
-// Packed to ensure consistent binary layout across compiler versions (Risk #3 fix)
-#pragma pack(push, 1)
-struct WaypointFrame {
-    // Position data from chassis.getPose()
-    float x;            // X position in inches
-    float y;            // Y position in inches  
-    float theta;        // Heading in degrees (LemLib returns degrees)
-    
-    // Timing
-    uint64_t timestamp; // Time since recording started (microseconds)
-    
-    // Mechanism states
-    int8_t intakePower;     // Intake motor power (-127 to 127)
-    int8_t outtakePower;    // Outtake motor power (-127 to 127)
-    
-    // Button states packed into bitflags for pneumatics
-    // Bit 0: R1 (intake forward) - reference only
-    // Bit 1: R2 (intake reverse) - reference only  
-    // Bit 2: L1 (outtake forward) - reference only
-    // Bit 3: L2 (outtake reverse) - reference only
-    // Bit 4: X (mid-scoring toggle)
-    // Bit 5: A (descore toggle)
-    // Bit 6: B (unloader toggle)
-    uint8_t buttons;
-    
-    // Flag to indicate if mechanism action occurred at this waypoint
-    bool hasAction;     // True if any mechanism was activated at this frame
+// Transform applied to a recording when it is loaded (kept as the plan's
+// placement, see compact_plan.h)
+// Angles follow LemLib's convention: degrees, 0 = +Y, clockwise positive
+struct RecordingTransform {
+    bool mirrorX = false;   // Mirror across the X axis (y -> -y, theta -> 180 - theta)
+    bool mirrorY = false;   // Mirror across the Y axis (x -> -x, theta -> -theta)
+    float rotation = 0;     // Clockwise rotation about the origin in degrees
+    float offsetX = 0;      // Translation in inches, applied after mirror/rotate
+    float offsetY = 0;
 };
-#pragma pack(pop)
 
-// Button bit positions
-constexpr uint8_t BTN_R1 = 0;
-constexpr uint8_t BTN_R2 = 1;
-constexpr uint8_t BTN_L1 = 2;
-constexpr uint8_t BTN_L2 = 3;
-constexpr uint8_t BTN_X  = 4;
-constexpr uint8_t BTN_A  = 5;
-constexpr uint8_t BTN_B  = 6;
+// Optional pre-run alignment: measures where the robot was actually placed
+// so odometry starts from the real pose instead of the nominal one
+struct StartAlignment {
+    bool useImuHeading = false;             // Take the start heading from the IMU
+    float imuHeadingOffset = 0;             // Field heading when the IMU reads 0 (degrees)
+    pros::Distance* distanceSensor = nullptr; // Wall-facing sensor (nullptr = unused)
+    float sensorHeading = 0;                // Sensor direction relative to robot front (degrees, clockwise)
+    float maxCorrection = 6.0f;             // Inches - larger shifts are treated as bad readings
+};
+
+// Where PositionReplay reads the robot pose from
+enum class PoseSource : uint8_t {
+    LemLib,     // chassis.getPose() / lemlib::estimatePose()
+    Fused       // odomScheduler fused wheel + drive encoder + IMU estimate
+};
+
+// Recording session state, advanced by PositionReplay::update()
+enum class RecordState : uint8_t {
+    Idle,       // Not recording
+    Countdown,  // Waiting for the scheduled start (driver keeps control)
+    Recording,  // Capturing frames
+    Saving      // Stopped; save task is writing the frames to SD
+};
+
+// State of the background SD load started by loadFromSDAsync()
+enum class LoadState : uint8_t {
+    Idle,       // No load requested
+    Loading,    // Background task is reading the file
+    Ready,      // Recording loaded
+    Failed      // Load finished without a usable recording
+};
+
+// What decides when a recorded mechanism action happens during playback
+enum class ActionTriggerMode : uint8_t {
+    Time,       // When the clock reaches its frame
+    Position    // When the robot reaches where it was recorded (see action_triggers.h)
+};
+
+// Tracking law that turns the plan into drive power (chosen per recording
+// slot, see RecordingLibrary::setSlotTracking())
+enum class TrackingMode : uint8_t {
+    Pursuit,    // PD on the point ahead (replay_controller.h)
+    Ramsete,    // Pose + reference velocity tracking (ramsete_controller.h)
+    Mpc         // Optimizes power over the next frames (mpc_controller.h)
+};
+
+// Outcome of a playback run
+enum class PlaybackResult : uint8_t {
+    None,       // No run (or the handle's run was superseded by a newer one)
+    Running,    // Playback task is driving the robot
+    Completed,  // Reached the end of the recording
+    Cancelled,  // cancel()/abortPlayback(), UP + DOWN, or disable
+    Failed      // Never started: no recording, or a save/load didn't finish
+};
+
+class PositionReplay;
+
+/**
+ * Observer for one playback run started by PositionReplay::playbackAsync()
+ *
+ * Copies refer to the same run and can be held by opcontrol, autonomous and
+ * the UI at once. Everything reads atomics written by the playback task, so
+ * queries never block. Once a newer run starts, this handle reports None.
+ */
+class PlaybackHandle {
+private:
+    PositionReplay* replay = nullptr;
+    uint32_t run = 0;
+
+public:
+    PlaybackHandle() = default;
+    PlaybackHandle(PositionReplay* replay, uint32_t run) : replay(replay), run(run) {}
+
+    bool valid() const { return replay != nullptr; }
+    bool isRunning() const;
+    PlaybackResult result() const;
+
+    float progress() const;             // 0..1 of the recording's duration
+    uint32_t currentFrame() const;      // Frame currently being pursued
+    float trackingError() const;        // Inches between target and achieved pose
+
+    /**
+     * Ask the playback task to stop; returns immediately
+     * The task is woken at once, so the motors stop within one control step
+     */
+    void cancel();
+
+    /**
+     * Block until the run has finished (motors stopped, run log written)
+     * @return true if it finished, false on timeout
+     */
+    bool wait(uint32_t timeoutMs = TIMEOUT_MAX);
+
+    /**
+     * Time from the stop request to the drive motors being commanded to 0
+     * (0 if the run wasn't cancelled)
+     */
+    uint32_t abortLatencyUs() const;
+};
 
 /**
  * Position-based recording and playback system using LemLib odometry
  */
 class PositionReplay {
+    friend class PlaybackHandle;
+
 private:
-    std::vector<WaypointFrame> recording;
+    FrameStore recording;                   // Capture buffer of the last recording made here
+    asset embeddedFile = {nullptr, 0};      // Embedded source, kept for re-transforming (mirror toggle)
+    asset fallbackFile = {nullptr, 0};      // Embedded recording loaded when an SD load fails
+    
+    // What playback runs: the recording resampled to a uniform grid, held
+    // quantized (see compact_plan.h)
+    CompactPlan plan;
+    uint32_t gridPeriod = 10;               // ms between plan frames (applied at the next load)
+    uint32_t planPeriodUs = 10000;          // Period the current plan was built with
+    uint32_t sourceFrameCount = 0;          // Frames in the recording the plan came from
+    bool planFromCache = false;             // Last plan was read from its .plan sidecar
+    ResampleReport lastResample;
+    
+    // Idle trimming, applied to every plan after resampling
+    bool trimIdleEnabled = true;
+    IdleTrimConfig idleTrim;
+    IdleTrimReport lastTrim;
     uint64_t recordStartTime = 0;
-    bool _isRecording = false;
-    bool _isPlaying = false;
-    bool _abortRequested = false;
+    std::atomic<RecordState> recordState{RecordState::Idle};
+    uint64_t countdownEnd = 0;          // micros() timestamp recording starts at
+    int countdownShown = 0;             // Seconds value currently displayed
+    std::atomic<uint8_t> saveReport{0}; // SD writer result for update(): 1 = saved, 2 = failed
+    std::atomic<uint32_t> lastSaveTimeMs{0};
+    
+    // Playback run state (written by the playback task, read through PlaybackHandle)
+    std::atomic<bool> _isPlaying{false};
+    std::atomic<bool> _abortRequested{false};
+    std::atomic<uint32_t> playbackRun{0};       // Id of the latest run
+    std::atomic<PlaybackResult> playbackResult{PlaybackResult::None};
+    std::atomic<uint32_t> playbackFrame{0};
+    std::atomic<float> playbackProgress{0};
+    std::atomic<float> trackingError{0};
+    std::atomic<uint32_t> abortRequestTime{0};  // Low 32 bits of micros() at the stop request
+    std::atomic<uint32_t> abortLatencyUs{0};    // Stop request to motors stopped, last run
+    pros::task_t playbackTask = nullptr;        // Task running the loop (woken by abortPlayback())
+    pros::Mutex playbackTaskMutex;              // Keeps playbackTask valid while notifying
     
     // Previous button states for edge detection
     uint8_t prevButtons = 0;
     uint8_t lastPlaybackButtons = 0;  // For edge detection during playback
     
-    // Previous errors for PID derivative term
-    float prevDistanceError = 0;
-    float prevHeadingError = 0;
+    // Tracking laws and their gains (see setGains()/setRamseteGains()/setMpcGains())
+    TrackingMode trackingMode = TrackingMode::Pursuit;
+    ReplayController controller;
+    RamseteController ramsete;
+    MpcController mpc;
+    uint32_t worstUpdateUs = 0;             // Slowest tracking law update in the last playback
     
     // Task priority tracking (Bug #2 fix)
     int originalPriority = TASK_PRIORITY_DEFAULT;
@@ -76,51 +199,136 @@ private:
     uint32_t recordingInterval = 25;        // Recording interval in ms (25ms = 40 samples/sec)
     uint32_t countdownDuration = 3000;      // Countdown before recording (ms)
     float actionTriggerRadius = 3.0f;       // Inches - radius for position-based action triggering
+    ActionTriggerMode actionTriggerMode = ActionTriggerMode::Time;
+    uint32_t actionWindowMs = 500;          // Position triggers arm/fall back this far from the recorded time
+    ActionTriggers actionTriggers;          // Events of the plan being played
+
+    // Re-syncing to the path after a push (0 = off)
+    float resyncDistance = 12.0f;           // Inches off the path (cross-track) that counts as knocked off it
+    uint32_t resyncCount = 0;               // Re-syncs in the last playback
+    PathIndex pathIndex;                    // Nearest-frame lookup over the plan being played
+    static constexpr uint32_t RESYNC_BACK_MS = 3000;    // How far back along the path to look
+    static constexpr uint32_t RESYNC_AHEAD_MS = 1000;   // ...and ahead
+    static constexpr uint32_t RESYNC_COOLDOWN_MS = 500; // Min time between re-syncs
     float lookaheadDistance = 15.0f;        // Pure pursuit lookahead distance in inches
     
+    // Pose source for recording and playback
+    PoseSource poseSource = PoseSource::LemLib;
+    
+    // Latency compensation (lemlib::estimatePose prediction in the playback loop)
+    float predictionHorizon = 0;            // ms ahead to predict; 0 = off, <0 = measured loop period
+    float measuredLoopPeriod = 20.0f;       // ms, smoothed playback loop period
+    float lastHorizonUsed = 0;              // ms, horizon used on the last tick
+    
+    // Achieved poses from the last playback (saved next to the recording)
+    RunLog runLog;
+    
     // File path for SD card storage
     std::string filePath = "/usd/position_recording.bin";
     
+    // CRC-32 of the current recording's file contents (header + frames)
+    uint32_t recordingChecksum = 0;
+    
+    // Field pose odometry is set to when a new recording starts
+    lemlib::Pose recordStartPose = lemlib::Pose(0, 0, 0);
+    
+    // Where the current recording started (stored in the file)
+    lemlib::Pose recordingStartPose = lemlib::Pose(0, 0, 0);
+    float startWallDistance = -1;           // Alignment sensor reading at record start (inches)
+    
+    // Pose odometry is set to when playback starts (the recording's start
+    // pose after any transform has been applied)
+    lemlib::Pose startPose = lemlib::Pose(0, 0, 0);
+    
+    // Pre-run placement estimate configuration
+    StartAlignment alignment;
+    
+    // Transform applied to every recording loaded from SD
+    RecordingTransform loadTransform;
+    
     // Last record time for interval-based recording
     uint64_t lastRecordTime = 0;
     
+    // Background load state (written by the load task, read by everyone else)
+    std::atomic<LoadState> loadState{LoadState::Idle};
+    std::atomic<uint32_t> loadedFrames{0};      // Frames read so far
+    std::atomic<uint32_t> loadTotalFrames{0};   // Frames in the file being read
+    std::atomic<bool> menuRedraw{false};        // Load finished; the UI task redraws the menu
+    uint32_t loadWaitTimeout = 1500;            // Max ms playback() waits for a pending load
+    
     // Helper methods
     void displayCountdown(int secondsRemaining);
+    void beginRecording(uint64_t startTime);
     bool checkEmergencyStop();
     uint8_t packButtons();
     bool wasPressed(uint8_t current, uint8_t prev, uint8_t bit);
     void executeActions(const WaypointFrame& frame, bool& midScoring, bool& descore, bool& unloader);
+    void applyToggles(uint8_t toggles, bool& midScoring, bool& descore, bool& unloader);
+    void updateCatalogEntry();
+    lemlib::Pose readPose(float horizonMs = 0);
+    void resetPose(const lemlib::Pose& pose);
+    float readWallDistance();
+    lemlib::Pose estimateStartPose();
+    bool readFromSD();
+    bool readFallback();
+    bool readRecordingFile(const std::string& path);
+    bool readEmbedded(const asset& file);
+    void buildPlan();
+    void storePlan(std::vector<GridFrame>& frames);
+    PlanCacheKey planCacheKey(uint32_t checksum, uint32_t sourceFrames) const;
+    void reportPlan();
+    bool claimPlayback();
+    void runPlayback();
+    void finishPlayback(PlaybackResult result);
     
 public:
     // ==================== Recording ====================
     
     /**
-     * Start recording with countdown
-     * Resets odometry to (0, 0, 0) for consistent reference
+     * Schedule a recording after the countdown and return immediately
+     * Recording begins (and odometry is reset to the field start pose, see
+     * setRecordStartPose()) on the first update() at or after the deadline
      */
     void startRecording();
     
     /**
-     * Stop recording and optionally save to SD
+     * Stop recording (or cancel the countdown) and optionally save to SD
+     * The frames are queued to the SD writer task; update() reports the result
      */
     void stopRecording(bool saveToSD = true);
     
     /**
-     * Record current position if interval has elapsed
-     * Call this every loop iteration (~20ms) - it internally handles timing
+     * Advance the countdown, record frames and report finished saves
+     * Call this every loop iteration (~20ms) - it never blocks
+     */
+    void update();
+    
+    /**
+     * Record current position if interval has elapsed (called by update())
      */
     void recordFrame();
     
     // ==================== Playback ====================
     
     /**
-     * Hybrid playback: Pure pursuit for motion, pauses for mechanism actions
-     * Uses chassis.moveToPose() for smooth motion between waypoints
+     * Time-synced tracking of the recording, blocking the caller until done
+     * Runs the same loop as playbackAsync() in the calling task
      */
     void playback();
     
     /**
-     * Abort playback (emergency stop)
+     * Start playback in its own task and return immediately
+     * @return handle to the run (invalid if recording or already playing)
+     */
+    PlaybackHandle playbackAsync();
+    
+    /**
+     * Handle to the current (or most recent) run
+     */
+    PlaybackHandle getPlayback() { return PlaybackHandle(this, playbackRun); }
+    
+    /**
+     * Abort playback (emergency stop); same as cancel() on the run's handle
      */
     void abortPlayback();
     
@@ -132,7 +340,9 @@ public:
     void clearRecording();
     
     /**
-     * Save recording to SD card in binary format
+     * Save the last recording made on this brain to SD, blocking until written
+     * Writes a temp file with a CRC-32 trailer, then replaces the old file
+     * (loaded recordings aren't kept raw, so there is nothing to save after a load)
      */
     bool saveToSD();
     
@@ -141,23 +351,134 @@ public:
      */
     bool loadFromSD();
     
+    /**
+     * Load recording from SD card in a background task and return immediately
+     * Progress is available through getLoadState()/getLoadProgress()
+     */
+    void loadFromSDAsync();
+    
+    /**
+     * Play a recording linked into the program (see RECORDING_ASSET)
+     * The linked plan is validated once (CRC) and played in place, with no
+     * copy and no SD card; replaced by the next recording or SD load
+     * @return false if the data isn't a valid plan or the buffer is busy
+     */
+    bool loadEmbedded(const asset& file);
+
+    /**
+     * Linked recording to load instead whenever an SD load fails (no card,
+     * empty slot, bad file), so the robot always has an auton to run
+     */
+    void setFallbackRecording(const asset& file) { fallbackFile = file; }
+    
+    /**
+     * Mirror/rotate/translate the loaded recording (kept as the plan's
+     * placement and applied as frames are decoded; the frames aren't rewritten)
+     */
+    void applyTransform(const RecordingTransform& transform);
+    
+    /**
+     * Rotate and translate the loaded recording so it starts at the given pose
+     */
+    void rebaseToStartPose(const lemlib::Pose& pose);
+    
+    /**
+     * Block until a pending background load finishes
+     * @return true if a recording is ready, false on failure or timeout
+     */
+    bool waitForLoad(uint32_t timeoutMs);
+    
     // ==================== Getters/Setters ====================
     
-    size_t getFrameCount() const { return recording.size(); }
-    static constexpr size_t MAX_FRAMES = 5000;
+    /**
+     * Take every recording/playback tunable from a parsed tuning file
+     */
+    void applyConfig(const TuningConfig& config);
+    
+    
+    bool isEmbedded() const { return embeddedFile.buf != nullptr; }
+    const asset& getEmbeddedFile() const { return embeddedFile; }
+    
+    /**
+     * The uniform-grid frames playback runs (frame k at k * getGridPeriod() ms)
+     */
+    const CompactPlan& getPlan() const { return plan; }
+    bool isPlanFromCache() const { return planFromCache; }
+    uint32_t getResyncCount() const { return resyncCount; }
+    uint32_t getGridPeriod() const { return planPeriodUs / 1000; }
+    const ResampleReport& getResampleReport() const { return lastResample; }
+    const IdleTrimReport& getTrimReport() const { return lastTrim; }
+    
+    size_t getFrameCount() const { return sourceFrameCount; }
+    uint32_t getChecksum() const { return recordingChecksum; }
+    const RunLog& getRunLog() const { return runLog; }
+    // Just after a recording the capture buffer and its plan are both held.
+    // At 25 ms per frame the plan has 2.5 frames per recorded one, so a
+    // frame costs 10 + 2.5 * 13 B (was 24 + 2.5 * 16 B with full-size
+    // frames). 7400 plus the pool's button log fit in the 320 KB 5000 used to
+    static constexpr size_t MAX_FRAMES = 7400;
+    static_assert(MAX_FRAMES <= FRAME_CHUNK_SIZE * (FRAME_POOL_CHUNKS - BUTTON_LOG_CHUNKS),
+                  "frame pool too small");
+    static constexpr size_t MAX_CACHED_PLAN_FRAMES = 60000;     // 10 minutes on a 10 ms grid
     
-    // Helper to find frame index for a given timestamp
-    size_t findFrameIndexAtTime(uint64_t elapsedMicros);
+    // Plan frame to chase at a given time (one division on the uniform grid)
+    size_t findFrameIndexAtTime(uint64_t elapsedMicros) const;
 
     uint32_t getDuration() const;
-    bool isRecording() const { return _isRecording; }
+    bool isRecording() const {
+        RecordState state = recordState;
+        return state == RecordState::Countdown || state == RecordState::Recording;
+    }
+    bool isCountingDown() const { return recordState == RecordState::Countdown; }
+    bool isSaving() const { return recordState == RecordState::Saving; }
     bool isPlaying() const { return _isPlaying; }
+    bool isLoading() const { return loadState == LoadState::Loading; }
+    LoadState getLoadState() const { return loadState; }
+    float getLoadProgress() const {
+        uint32_t total = loadTotalFrames;
+        return total > 0 ? static_cast<float>(loadedFrames) / total : 0.0f;
+    }
+
+    /**
+     * True once after a background load finishes. The load task never draws
+     * (the screen belongs to whichever task runs the menu); that task polls
+     * this and getLoadProgress() and redraws
+     */
+    bool takeMenuRedraw() { return menuRedraw.exchange(false); }
     
     void setRecordingInterval(uint32_t ms) { recordingInterval = ms; }
+    void setGridPeriod(uint32_t ms) { gridPeriod = ms > 0 ? ms : 1; }   // Takes effect on the next load
+    void setIdleTrim(bool enabled, const IdleTrimConfig& config) {          // Takes effect on the next load
+        trimIdleEnabled = enabled;
+        idleTrim = config;
+    }
     void setCountdownDuration(uint32_t ms) { countdownDuration = ms; }
     void setActionTriggerRadius(float inches) { actionTriggerRadius = inches; }
+    void setActionTriggerMode(ActionTriggerMode mode) { actionTriggerMode = mode; }    // Takes effect on the next playback
+    void setActionWindow(uint32_t ms) { actionWindowMs = ms; }
+    void setResyncDistance(float inches) { resyncDistance = inches; }   // 0 = always chase the clock
     void setLookaheadDistance(float inches) { lookaheadDistance = inches; }
+    void setPredictionHorizon(float ms) { predictionHorizon = ms; }
+    void setPoseSource(PoseSource source);      // Fused also turns the fused estimate on
+    void setGains(const ReplayGains& gains) { controller.setGains(gains); }
+    const ReplayGains& getGains() const { return controller.getGains(); }
+    void setRamseteGains(const RamseteGains& gains) { ramsete.setGains(gains); }
+    const RamseteGains& getRamseteGains() const { return ramsete.getGains(); }
+    void setMpcGains(const MpcGains& gains) { mpc.setGains(gains); }
+    const MpcGains& getMpcGains() const { return mpc.getGains(); }
+    uint32_t getWorstUpdateUs() const { return worstUpdateUs; }
+    void setTrackingMode(TrackingMode mode) { trackingMode = mode; }    // Takes effect on the next playback
+    TrackingMode getTrackingMode() const { return trackingMode; }
+    uint32_t getAbortLatencyUs() const { return abortLatencyUs; }
+    float getMeasuredLoopPeriod() const { return measuredLoopPeriod; }
+    float getPredictionHorizon() const { return lastHorizonUsed; }
     void setFilePath(const std::string& path) { filePath = path; }
+    void setLoadWaitTimeout(uint32_t ms) { loadWaitTimeout = ms; }
+    void setLoadTransform(const RecordingTransform& transform) { loadTransform = transform; }
+    const RecordingTransform& getLoadTransform() const { return loadTransform; }
+    lemlib::Pose getStartPose() const { return startPose; }
+    void setRecordStartPose(const lemlib::Pose& pose) { recordStartPose = pose; }
+    void setStartAlignment(const StartAlignment& config) { alignment = config; }
     
     // ==================== Status Display ====================
     
@@ -0,0 +1,60 @@
+#pragma once
+#include "replay_controller.h"
+
+/**
+ * Ramsete Tracking Controller
+ *
+ * Nonlinear unicycle tracking law: the pose error is taken in the robot's
+ * frame and corrected on top of the reference velocity the plan derives at
+ * each frame (see CompactPlan), so the robot converges back onto the path
+ * from a displaced start or a shove instead of just steering at a point.
+ *
+ *   k     = 2 zeta sqrt(w_r^2 + b v_r^2)
+ *   v     = v_r cos(e_theta) + k e_x
+ *   omega = w_r + k e_theta + b v_r sinc(e_theta) e_y
+ *
+ * The body command becomes left/right wheel velocity targets, applied open
+ * loop as power in proportion to the drive's top speed (scaled together if
+ * either side would saturate, so the curvature is kept).
+ *
+ * No PROS dependency, so the simulator in tools/ runs the same code.
+ */
+
+struct RamseteGains {
+    // Convergence gain, 1/m^2 (the usual units; converted internally). The
+    // textbook 2.0 is for full-size robots; a VEX drive tracks best far
+    // stiffer (tools/tracking_bench.cpp)
+    float b = 32.0f;
+    float zeta = 0.9f;          // Damping, 0..1
+    float maxSpeed = 76.6f;     // in/s at full power (450 rpm, 3.25" omnis)
+    float trackWidth = 11.5f;   // Inches
+};
+
+// Wheel velocity targets, in/s
+struct WheelSpeeds {
+    float left;
+    float right;
+};
+
+class RamseteController {
+private:
+    RamseteGains gains;
+
+public:
+    explicit RamseteController(const RamseteGains& gains = RamseteGains()) : gains(gains) {}
+
+    void reset() {}
+
+    /**
+     * Wheel velocities that bring the robot at (x, y, theta) onto the target
+     */
+    WheelSpeeds wheelSpeeds(const TrackingTarget& target, float x, float y, float theta) const;
+
+    /**
+     * wheelSpeeds() as an arcade power command
+     */
+    DriveCommand update(const TrackingTarget& target, float x, float y, float theta);
+
+    void setGains(const RamseteGains& newGains) { gains = newGains; }
+    const RamseteGains& getGains() const { return gains; }
+};
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * Recording File Format
+ *
+ * On-card layout of a position recording. Kept free of PROS/LemLib so host
+ * tools (see tools/) can read the same files the brain writes.
+ */
+
+// Single waypoint frame - captures position and mechanism states at a moment in time
+// Packed to ensure consistent binary layout across compiler versions (Risk #3 fix)
+#pragma pack(push, 1)
+struct WaypointFrame {
+    // Position data from chassis.getPose()
+    float x;            // X position in inches
+    float y;            // Y position in inches  
+    float theta;        // Heading in degrees (LemLib returns degrees)
+    
+    // Timing
+    uint64_t timestamp; // Time since recording started (microseconds)
+    
+    // Mechanism states
+    int8_t intakePower;     // Intake motor power (-127 to 127)
+    int8_t outtakePower;    // Outtake motor power (-127 to 127)
+    
+    // Button states packed into bitflags for pneumatics
+    // Bit 0: R1 (intake forward) - reference only
+    // Bit 1: R2 (intake reverse) - reference only  
+    // Bit 2: L1 (outtake forward) - reference only
+    // Bit 3: L2 (outtake reverse) - reference only
+    // Bit 4: X (mid-scoring toggle)
+    // Bit 5: A (descore toggle)
+    // Bit 6: B (unloader toggle)
+    uint8_t buttons;
+    
+    // Flag to indicate if mechanism action occurred at this waypoint
+    bool hasAction;     // True if any mechanism was activated at this frame
+};
+#pragma pack(pop)
+
+// Frame on the uniform playback grid (see resampler.h)
+// A WaypointFrame without its timestamp: frame k is at k * grid period
+#pragma pack(push, 1)
+struct GridFrame {
+    float x;            // Inches
+    float y;
+    float theta;        // Degrees
+    int8_t intakePower;     // Latest recorded power at or before this point
+    int8_t outtakePower;
+    uint8_t toggles;        // BTN_X/A/B bits pressed an odd number of times since the previous point
+    bool hasAction;         // Any recorded action since the previous point
+};
+#pragma pack(pop)
+
+// Button bit positions
+constexpr uint8_t BTN_R1 = 0;
+constexpr uint8_t BTN_R2 = 1;
+constexpr uint8_t BTN_L1 = 2;
+constexpr uint8_t BTN_L2 = 3;
+constexpr uint8_t BTN_X  = 4;
+constexpr uint8_t BTN_A  = 5;
+constexpr uint8_t BTN_B  = 6;
+
+// What marks a frame as an action (WaypointFrame::hasAction): a pneumatic
+// toggle pressed since the previous frame, or a mechanism under real power
+inline bool isActionFrame(uint8_t buttons, uint8_t prevButtons, int8_t intakePower,
+                          int8_t outtakePower) {
+    uint8_t pressed = buttons & ~prevButtons;
+    constexpr uint8_t toggles = (1 << BTN_X) | (1 << BTN_A) | (1 << BTN_B);
+    return (pressed & toggles) != 0 || intakePower > 10 || intakePower < -10 ||
+           outtakePower > 10 || outtakePower < -10;
+}
+
+// Recording file format
+// v1: header (magic, version, frame count) + frames
+// v2: v1 + CRC-32 trailer over header and frames
+// v3: v2 + start info after the header
+constexpr uint32_t RECORDING_MAGIC = 0x504F5352; // "POSR"
+constexpr uint32_t RECORDING_VERSION = 3;
+
+// Where the recording started on the field (v3+)
+#pragma pack(push, 1)
+struct RecordingStartInfo {
+    float x;            // Field start pose (inches / degrees)
+    float y;
+    float theta;
+    float wallDistance; // Alignment sensor reading at start (inches, <0 = none)
+};
+#pragma pack(pop)
@@ -0,0 +1,97 @@
+#pragma once
+#include "main.h"
+#include "position_replay.h"
+#include <cstdint>
+#include <string>
+
+/**
+ * Multi-Slot Recording Library
+ *
+ * Keeps several named recordings on the SD card and a small catalog file
+ * describing them, so the menu can list every slot without opening the
+ * recordings themselves. Only the selected slot's file is ever loaded.
+ */
+
+// One catalog record per slot - packed so the catalog is read in one fread
+#pragma pack(push, 1)
+struct CatalogEntry {
+    char name[16];          // Display name (null-terminated)
+    uint32_t durationMs;    // Recording length in ms
+    uint32_t frameCount;    // Number of frames in the slot file
+    uint32_t checksum;      // CRC-32 of the slot file (header + frames)
+    float startX;           // First frame pose (inches / degrees)
+    float startY;
+    float startTheta;
+    uint8_t used;           // 1 if the slot holds a recording
+    uint8_t tracking;       // TrackingMode playback uses for this slot (v2+)
+};
+#pragma pack(pop)
+
+/**
+ * Catalog of recording slots stored on the SD card
+ */
+class RecordingLibrary {
+public:
+    static constexpr size_t MAX_SLOTS = 4;
+
+private:
+    CatalogEntry entries[MAX_SLOTS];
+    size_t activeSlot = 0;
+
+    // File path for the catalog
+    std::string catalogPath = "/usd/recordings.idx";
+
+    void resetEntries();
+
+public:
+    RecordingLibrary();
+
+    // ==================== Catalog ====================
+
+    /**
+     * Read the catalog (single small read - safe to call in initialize())
+     * Falls back to empty slots if the file is missing or invalid
+     */
+    bool loadCatalog();
+
+    /**
+     * Write the catalog back to the SD card
+     */
+    bool saveCatalog();
+
+    /**
+     * Update the active slot's entry after its recording was saved
+     */
+    void updateActiveSlot(uint32_t frameCount, uint32_t durationMs, uint32_t checksum,
+                          float startX, float startY, float startTheta);
+
+    // ==================== Slots ====================
+
+    /**
+     * Make a slot active and start loading its recording (if it has one)
+     * into positionReplay in the background
+     * @return true if a load was started
+     */
+    bool selectSlot(size_t slot);
+
+    /**
+     * SD card path of a slot's recording file
+     */
+    std::string slotPath(size_t slot) const;
+
+    void setSlotName(size_t slot, const char* name);
+
+    /**
+     * Choose the tracking law a slot plays with (saved in the catalog;
+     * applied straight away if the slot is active)
+     */
+    void setSlotTracking(size_t slot, TrackingMode mode);
+
+    // ==================== Getters ====================
+
+    size_t getActiveSlot() const { return activeSlot; }
+    const CatalogEntry& getEntry(size_t slot) const { return entries[slot]; }
+};
+
+// Global instance
+extern RecordingLibrary recordingLibrary;
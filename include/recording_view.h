@@ -0,0 +1,26 @@
+#pragma once
+#include "lemlib/asset.hpp"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Recordings Linked Into the Program
+ *
+ * An embedded recording is linked in as its built playback plan: the .plan
+ * file tools/embed_plan.cpp makes from a recording (the same layout as the
+ * plan cache on the card, see plan_cache.h). loadEmbedded() checks its CRC
+ * and plays the quantized frames straight from the linked read-only bytes,
+ * so the recording takes no RAM for its frames and needs no SD card.
+ *
+ * Recordings (the .bin the brain writes) go in recordings/. The Makefile
+ * builds a .plan next to each one and archives the plans into the cold
+ * package, so uploading new code doesn't resend them. The plan for
+ * recordings/match_left.bin is declared with:
+ *   RECORDING_ASSET(match_left_plan);
+ */
+
+#define RECORDING_ASSET(x)                                                                                             \
+    extern "C" {                                                                                                       \
+    extern uint8_t _binary_recordings_##x##_start[], _binary_recordings_##x##_size[];                                  \
+    static asset x = {_binary_recordings_##x##_start, (size_t)_binary_recordings_##x##_size};                          \
+    }
@@ -0,0 +1,70 @@
+#pragma once
+
+/**
+ * Playback Tracking Controller
+ *
+ * The PD pursuit law PositionReplay::playback() uses to chase the moving
+ * target frame, with its gains in a runtime struct instead of locals.
+ * No PROS dependency, so tools/pd_tuner.cpp can run the exact same law
+ * against a simulated drivetrain.
+ */
+
+// PD gains (defaults are the tuned LemLib values from robot_config.cpp)
+struct ReplayGains {
+    float kP_forward = 5.0f;
+    float kD_forward = 8.0f;
+    float kP_turn = 1.7f;
+    float kD_turn = 14.0f;
+};
+
+// Arcade command, each clamped to -127..127 (left = forward + turn,
+// right = forward - turn)
+struct DriveCommand {
+    float forward;
+    float turn;
+};
+
+// Plan frame being chased, with the motion derived along the plan
+struct TrackingTarget {
+    float x;            // Inches
+    float y;
+    float theta;        // Degrees
+    float speed;        // in/s along the heading, negative when reversing
+    float turnRate;     // deg/s, clockwise positive
+};
+
+/**
+ * Stateful PD law - call reset() before every run, update() once per tick
+ */
+class ReplayController {
+private:
+    ReplayGains gains;
+
+    // Previous errors for the derivative terms
+    float prevDistanceError = 0;
+    float prevHeadingError = 0;
+
+public:
+    explicit ReplayController(const ReplayGains& gains = ReplayGains()) : gains(gains) {}
+
+    void reset() {
+        prevDistanceError = 0;
+        prevHeadingError = 0;
+    }
+
+    /**
+     * Command that drives the robot at (x, y, theta) towards the target frame
+     */
+    DriveCommand update(float targetX, float targetY, float targetTheta,
+                        float x, float y, float theta);
+
+    /**
+     * Same, from a tracking target (the PD law only uses its pose)
+     */
+    DriveCommand update(const TrackingTarget& target, float x, float y, float theta) {
+        return update(target.x, target.y, target.theta, x, y, theta);
+    }
+
+    void setGains(const ReplayGains& newGains) { gains = newGains; }
+    const ReplayGains& getGains() const { return gains; }
+};
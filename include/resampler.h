@@ -0,0 +1,72 @@
+#pragma once
+#include "recording_format.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Uniform Time-Grid Resampler
+ *
+ * recordFrame() only fires when the driver loop happens to pass the
+ * interval, so recorded timestamps are irregular. Playback instead runs from
+ * frames on a strict grid (frame k at k * period), so looking up the target
+ * is one division and no timestamps are kept in memory.
+ *
+ * - Pose: linear in x/y, shortest-way for theta
+ * - Motor powers: the latest recorded value at or before each grid point
+ * - Toggle presses (X/A/B): carried to the first grid point at or after the
+ *   press, so none are lost or moved earlier however coarse the grid is
+ *
+ * Frames are fed one at a time so a file can be resampled while it is read,
+ * without holding the source frames.
+ */
+
+// What the resampler found in the source timestamps
+struct ResampleReport {
+    uint32_t sourceFrames = 0;
+    uint32_t gridFrames = 0;
+    uint32_t droppedSamples = 0;    // Missing source samples (gaps over 1.5x the nominal interval)
+    uint32_t longestGapMs = 0;      // Largest gap between source samples
+    uint32_t outOfOrder = 0;        // Frames skipped for not moving time forward
+};
+
+/**
+ * Streaming resampler: begin(), add() every source frame in order, finish()
+ */
+class GridResampler {
+private:
+    std::vector<GridFrame>* out = nullptr;
+    uint32_t periodUs = 10000;
+    uint32_t nominalUs = 25000;
+    uint64_t nextTime = 0;          // Time of the next grid point to emit
+    WaypointFrame prev = {};
+    bool hasPrev = false;
+    uint8_t pendingToggles = 0;     // Presses waiting for the next grid point
+    bool pendingAction = false;
+    ResampleReport report;
+
+    void emit(const WaypointFrame& from, const WaypointFrame& to, uint64_t time);
+
+public:
+    /**
+     * @param out Cleared and filled with grid frames
+     * @param periodUs Grid period
+     * @param nominalIntervalUs Expected source interval, for dropped-sample detection
+     */
+    void begin(std::vector<GridFrame>& out, uint32_t periodUs, uint32_t nominalIntervalUs);
+
+    void add(const WaypointFrame& frame);
+
+    /**
+     * Emit the final grid point (at or after the last source frame)
+     */
+    ResampleReport finish();
+    
+    uint32_t getPeriod() const { return periodUs; }
+};
+
+/**
+ * Resample a whole buffer in one call
+ */
+ResampleReport resampleToGrid(const WaypointFrame* frames, size_t count, uint32_t periodUs,
+                              uint32_t nominalIntervalUs, std::vector<GridFrame>& out);
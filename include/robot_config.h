@@ -15,6 +15,8 @@ extern pros::MotorGroup right_motors;
 
 extern lemlib::Drivetrain drivetrain;
 extern lemlib::TrackingWheel vertical_tracking_wheel;
+extern lemlib::TrackingWheel left_drive_wheel;
+extern lemlib::TrackingWheel right_drive_wheel;
 extern lemlib::OdomSensors sensors;
 extern lemlib::Chassis chassis;
 
@@ -0,0 +1,120 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Playback Run Log
+ *
+ * Captures the pose the robot actually reached on every playback tick,
+ * alongside the recorded target it was chasing, into a buffer reserved
+ * before the run starts. After the run the log is summarised and written
+ * next to the recording ("<recording>.run") so tools/run_log_report.cpp can
+ * break the error down per segment on a host.
+ *
+ * No PROS dependency - the same code reads and scores logs on the host.
+ * Angles follow LemLib's convention: degrees, 0 = +Y, clockwise positive.
+ */
+
+// One playback tick - packed so the log is written in one fwrite
+#pragma pack(push, 1)
+struct RunSample {
+    uint32_t elapsedMs;     // Time since playback started
+    uint32_t targetMs;      // Recorded timestamp of the target frame
+    uint16_t frameIndex;    // Target frame in the recording
+    uint8_t flags;          // RUN_FLAG_* bits
+    uint8_t reserved;
+    float x;                // Achieved pose (inches / degrees)
+    float y;
+    float theta;
+    float targetX;          // Target frame position as played (after transforms)
+    float targetY;
+};
+
+// Whole-run metrics, stored in the log header
+struct RunSummary {
+    uint32_t sampleCount;
+    uint32_t durationMs;        // Playback time
+    float rmsCrossTrack;        // Inches - distance to the played path
+    float maxCrossTrack;        // Inches
+    float finalPositionError;   // Inches - last sample vs last recorded frame
+    float finalHeadingError;    // Degrees
+    float meanTimeBehind;       // ms - positive means behind schedule
+    float maxTimeBehind;        // ms
+};
+#pragma pack(pop)
+
+// Sample flag bits
+constexpr uint8_t RUN_FLAG_ACTION = 0x01;   // Target frame carries a mechanism action
+constexpr uint8_t RUN_FLAG_RESYNC = 0x02;   // Clock re-synced to the nearest frame this tick
+
+// Cross-track error and schedule lag of one sample
+struct SampleError {
+    float crossTrack;       // Inches
+    float timeBehind;       // ms
+};
+
+/**
+ * Fixed-capacity per-tick log of a playback run
+ */
+class RunLog {
+public:
+    static constexpr size_t MAX_SAMPLES = 6400;     // 128 s at 20 ms per tick
+
+private:
+    std::vector<RunSample> samples;
+    RunSummary summary = {};
+    uint32_t recordingChecksum = 0;     // Recording the run was played from
+    bool overflowed = false;
+
+public:
+    // ==================== Capture ====================
+
+    /**
+     * Start a new log. Reserves the whole buffer up front so add() never
+     * allocates inside the control loop.
+     */
+    void begin(uint32_t checksum);
+
+    /**
+     * Append one tick (dropped once the buffer is full)
+     */
+    void add(const RunSample& sample) {
+        if (samples.size() < MAX_SAMPLES)
+            samples.push_back(sample);
+        else
+            overflowed = true;
+    }
+
+    /**
+     * Score the run against the last recorded frame
+     */
+    const RunSummary& finish(float finalX, float finalY, float finalTheta);
+
+    // ==================== Analysis ====================
+
+    /**
+     * Cross-track error and time behind schedule of sample `index`, measured
+     * against the played path (the target positions of nearby samples)
+     */
+    SampleError measure(size_t index) const;
+
+    // ==================== Storage ====================
+
+    /**
+     * Log file that belongs to a recording ("/usd/x.bin" -> "/usd/x.run")
+     */
+    static std::string pathFor(const std::string& recordingPath);
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    // ==================== Getters ====================
+
+    size_t size() const { return samples.size(); }
+    const RunSample& operator[](size_t index) const { return samples[index]; }
+    const RunSummary& getSummary() const { return summary; }
+    uint32_t getRecordingChecksum() const { return recordingChecksum; }
+    bool didOverflow() const { return overflowed; }
+};
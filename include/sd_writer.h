@@ -0,0 +1,76 @@
+#pragma once
+#include "main.h"
+#include "file_replace.h"
+#include "frame_store.h"
+#include "recording_format.h"
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+
+/**
+ * Background SD Card Writer
+ *
+ * Recording saves are queued to a low-priority I/O task so the driver loop
+ * never waits on the card. A queued job owns its frame buffer (it is moved
+ * in, not copied) and hands it back through onComplete once written.
+ */
+
+// One recording to write
+struct RecordingSaveJob {
+    std::string path;                       // Destination (a .tmp is written first)
+    FrameStore frames;                      // Owned by the job while queued
+    RecordingStartInfo start = {0, 0, 0, -1};
+
+    // Filled in by the writer
+    bool ok = false;
+    uint32_t checksum = 0;                  // CRC-32 of the written file
+    uint32_t writeTimeMs = 0;
+
+    // Runs on the I/O task once the write finished (or failed); move the
+    // frames back out here
+    std::function<void(RecordingSaveJob&)> onComplete = nullptr;
+};
+
+/**
+ * Write a complete recording file: temp file, CRC-32 trailer, then replace
+ * the old file. Used by the writer task and by synchronous saves.
+ */
+bool writeRecordingFile(const std::string& path, const RecordingStartInfo& start,
+                        const FrameStore& frames, uint32_t& checksum);
+
+/**
+ * Owns the I/O task and its job queue
+ */
+class SdWriter {
+public:
+    static constexpr size_t MAX_PENDING = 2;
+
+private:
+    pros::Task* task = nullptr;
+    pros::Mutex mutex;
+    std::deque<RecordingSaveJob> pending;
+    bool busy = false;
+
+    void run();
+
+public:
+    /**
+     * Start the I/O task (done automatically by the first submit())
+     */
+    void start();
+
+    /**
+     * Queue a save. The job (and its frames) is only moved from on success.
+     * @return false if the queue is full
+     */
+    bool submit(RecordingSaveJob&& job);
+
+    /**
+     * True while a job is queued or being written
+     */
+    bool isBusy();
+};
+
+// Global instance
+extern SdWriter sdWriter;
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Uniform Spatial Grid
+ *
+ * Buckets points (given by index) into square cells over their bounding
+ * box, so a position query only looks at the cells near it. Each cell lists
+ * its points in index order, which the callers rely on: plan frames and
+ * plan events are both indexed in time order.
+ *
+ * Shared by ActionTriggers (events near the robot) and PathIndex (nearest
+ * plan frame), so both are bucketed the same way.
+ */
+
+struct GridPoint {
+    float x;
+    float y;
+};
+
+class SpatialGrid {
+public:
+    static constexpr int MAX_CELLS = 4096;  // A larger area just gets bigger cells
+
+    // Point indices in one cell, in index order
+    struct Cell {
+        const uint32_t* first = nullptr;
+        const uint32_t* last = nullptr;
+        const uint32_t* begin() const { return first; }
+        const uint32_t* end() const { return last; }
+    };
+
+private:
+    float size = 1.0f;
+    float minX = 0;
+    float minY = 0;
+    int cols = 0;
+    int rows = 0;
+
+    // Points in cell c are cellPoints[cellStart[c] .. cellStart[c + 1])
+    std::vector<uint32_t> cellStart;
+    std::vector<uint32_t> cellPoints;
+
+    int cellOf(float value, float origin) const;
+
+public:
+    /**
+     * Bucket `points` (point i is index i)
+     * @param cellSize Smallest cell size in inches; doubled until the grid
+     *                 has at most MAX_CELLS cells
+     */
+    void build(const std::vector<GridPoint>& points, float cellSize);
+
+    void clear();
+    bool empty() const { return cols == 0; }
+
+    float cellSize() const { return size; }
+    int getCols() const { return cols; }
+    int getRows() const { return rows; }
+
+    // Cell coordinates of a position (may be outside 0..cols-1 / 0..rows-1)
+    int col(float x) const { return cellOf(x, minX); }
+    int row(float y) const { return cellOf(y, minY); }
+
+    /**
+     * Points in one cell; empty for a cell outside the grid
+     */
+    Cell cell(int col, int row) const;
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include "mpc_controller.h"
+#include "ramsete_controller.h"
+#include "replay_controller.h"
+#include <cstdint>
+#include <string>
+
+/**
+ * SD Card Tuning File
+ *
+ * Every tunable that used to need a rebuild, read from a plain
+ * "key = value" text file on the SD card:
+ *
+ *     # /usd/tuning.cfg
+ *     kP_forward = 5
+ *     kD_turn = 14
+ *     deadband = 8
+ *
+ * The file is parsed once (at boot, or when CFG is tapped on the brain
+ * screen) into a POD struct that everything else reads directly. Missing
+ * keys keep their defaults; if the file doesn't exist a template with the
+ * defaults is written so there's something to edit.
+ */
+
+// Parsed tunables (defaults are the values that used to be compiled in)
+struct TuningConfig {
+    ReplayGains gains;                  // Playback PD gains
+    RamseteGains ramsete;               // Ramsete tracking gains (b, zeta)
+    MpcGains mpc;                       // MPC horizon, iterations and weights
+    uint32_t recordingInterval = 25;    // ms between recorded frames
+    uint32_t gridPeriod = 10;           // ms between resampled playback frames
+    uint32_t trimIdle = 1;              // 1 = shorten stationary stretches at load
+    uint32_t idleDwell = 300;           // ms each trimmed stretch keeps
+    float idleSpeed = 1.0f;             // in/s below which the robot counts as stopped
+    uint32_t countdownDuration = 3000;  // ms before recording starts
+    float actionTriggerRadius = 3.0f;   // Inches
+    uint32_t actionTrigger = 0;         // 0 = actions by time, 1 = by position
+    uint32_t actionWindow = 500;        // ms position triggers may be early/late
+    float resyncDistance = 12.0f;       // Inches off the path before re-syncing (0 = off)
+    float predictionHorizon = 0;        // ms, see PositionReplay::setPredictionHorizon()
+    int32_t driveDeadband = 8;          // Joystick deadband in opcontrol()
+};
+
+/**
+ * Tuning file reader/writer
+ */
+class TuningFile {
+private:
+    TuningConfig config;
+    std::string path = "/usd/tuning.cfg";
+
+    // Result of the last load()
+    int keysRead = 0;
+    int badLines = 0;
+
+    bool parseLine(char* line);
+
+public:
+    /**
+     * Parse the file into the config (unlisted keys reset to defaults)
+     * Writes a template with the defaults if the file doesn't exist
+     * @return true if the file was read
+     */
+    bool load();
+
+    /**
+     * Write the current config as a commented key = value file
+     */
+    bool save() const;
+
+    const TuningConfig& get() const { return config; }
+    int getKeysRead() const { return keysRead; }
+    int getBadLines() const { return badLines; }
+    void setPath(const std::string& newPath) { path = newPath; }
+};
+
+// Global instance
+extern TuningFile tuningFile;
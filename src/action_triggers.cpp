@@ -0,0 +1,71 @@
+#include "action_triggers.h"
+#include <algorithm>
+#include <cstdlib>
+
+// Power changes smaller than this are drift in the recorded voltage, not a
+// new command (same threshold recordFrame() uses for an action)
+static constexpr int POWER_STEP = 10;
+
+void ActionTriggers::build(const CompactPlan &plan, float radius) {
+  this->radius = std::max(radius, 0.1f);
+  events.clear();
+  nextEvent = 0;
+
+  // Events: piston presses, and power changes from the last event's powers
+  int8_t intake = 0;
+  int8_t outtake = 0;
+  for (size_t k = 0; k < plan.size(); k++) {
+    GridFrame frame = plan[k];
+    bool powerChange = std::abs(frame.intakePower - intake) > POWER_STEP ||
+                       std::abs(frame.outtakePower - outtake) > POWER_STEP;
+    if (frame.toggles == 0 && !powerChange)
+      continue;
+    events.push_back({static_cast<uint32_t>(k), frame.x, frame.y,
+                      frame.intakePower, frame.outtakePower, frame.toggles});
+    intake = frame.intakePower;
+    outtake = frame.outtakePower;
+  }
+
+  // Cells at least one radius across, so everything within the radius of
+  // the robot is in the 3x3 cells around it
+  std::vector<GridPoint> points;
+  points.reserve(events.size());
+  for (const PlanEvent &event : events) {
+    points.push_back({event.x, event.y});
+  }
+  grid.build(points, this->radius);
+}
+
+size_t ActionTriggers::update(float x, float y, size_t timeFrame,
+                              size_t windowFrames) {
+  if (nextEvent >= events.size())
+    return nextEvent;
+
+  size_t due = nextEvent; // Fire everything before this
+
+  // Fallback: events whose window has passed
+  while (due < events.size() && events[due].frame + windowFrames <= timeFrame) {
+    due++;
+  }
+
+  // Armed events the robot is at
+  int cx = grid.col(x);
+  int cy = grid.row(y);
+  float radiusSquared = radius * radius;
+  for (int row = cy - 1; row <= cy + 1; row++) {
+    for (int col = cx - 1; col <= cx + 1; col++) {
+      for (uint32_t id : grid.cell(col, row)) {
+        const PlanEvent &event = events[id];
+        if (id < due || event.frame > timeFrame + windowFrames)
+          continue;
+        float dx = event.x - x;
+        float dy = event.y - y;
+        if (dx * dx + dy * dy <= radiusSquared)
+          due = id + 1;
+      }
+    }
+  }
+
+  nextEvent = due;
+  return nextEvent;
+}
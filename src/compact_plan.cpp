@@ -0,0 +1,246 @@
+#include "compact_plan.h"
+#include "crc32.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static int16_t quantize(float value, float step) {
+  long units = std::lround(value / step);
+  return static_cast<int16_t>(std::clamp(units, -32768L, 32767L));
+}
+
+// ==================== Placement ====================
+
+void PlanPlacement::apply(float &x, float &y, float &theta) const {
+  float px = xx * x + xy * y + dx;
+  float py = yx * x + yy * y + dy;
+  x = px;
+  y = py;
+  theta = (mirrored ? -theta : theta) + headingOffset;
+}
+
+PlanPlacement PlanPlacement::then(const PlanPlacement &next) const {
+  PlanPlacement out;
+  out.xx = next.xx * xx + next.xy * yx;
+  out.xy = next.xx * xy + next.xy * yy;
+  out.yx = next.yx * xx + next.yy * yx;
+  out.yy = next.yx * xy + next.yy * yy;
+  out.dx = next.xx * dx + next.xy * dy + next.dx;
+  out.dy = next.yx * dx + next.yy * dy + next.dy;
+  out.mirrored = mirrored != next.mirrored;
+  out.headingOffset =
+      (next.mirrored ? -headingOffset : headingOffset) + next.headingOffset;
+  return out;
+}
+
+// ==================== Encoding ====================
+
+void CompactPlan::encode(const std::vector<GridFrame> &source,
+                         uint32_t periodUs) {
+  this->periodUs = periodUs > 0 ? periodUs : 10000;
+  encodeFrames(source);
+  deriveMotion(source);
+  placement = PlanPlacement();
+  placed = false;
+  useOwned();
+}
+
+void CompactPlan::place(const PlanPlacement &next) {
+  placement = placement.then(next);
+  placed = true;
+}
+
+void CompactPlan::useOwned() {
+  frames = ownedFrames.data();
+  motion = ownedMotion.data();
+  count = ownedFrames.size();
+}
+
+void CompactPlan::encodeFrames(const std::vector<GridFrame> &source) {
+  ownedFrames.clear();
+  ownedFrames.shrink_to_fit();
+  if (source.empty())
+    return;
+
+  // Centre of the path, so the +/-327 in range is split evenly around it
+  float minX = source[0].x, maxX = minX, minY = source[0].y, maxY = minY;
+  for (const GridFrame &frame : source) {
+    minX = std::min(minX, frame.x);
+    maxX = std::max(maxX, frame.x);
+    minY = std::min(minY, frame.y);
+    maxY = std::max(maxY, frame.y);
+  }
+  originX = (minX + maxX) / 2;
+  originY = (minY + maxY) / 2;
+  ownedFrames.reserve(source.size());
+
+  for (const GridFrame &frame : source) {
+    PlanFrame packed;
+    packed.x = quantize(frame.x - originX, PLAN_POSITION_STEP);
+    packed.y = quantize(frame.y - originY, PLAN_POSITION_STEP);
+
+    // A whole turn is 65536 units, so the heading wraps instead of clamping
+    long angle = std::lround(std::remainder(frame.theta, 360.0f) / PLAN_ANGLE_STEP);
+    packed.theta = static_cast<int16_t>(static_cast<uint16_t>(angle));
+
+    packed.intakePower = frame.intakePower;
+    packed.outtakePower = frame.outtakePower;
+    packed.flags = frame.toggles | (frame.hasAction ? 1 << PLAN_ACTION_BIT : 0);
+    ownedFrames.push_back(packed);
+  }
+}
+
+// Central differences on the full-precision frames (one-sided at the ends)
+void CompactPlan::deriveMotion(const std::vector<GridFrame> &source) {
+  ownedMotion.clear();
+  ownedMotion.shrink_to_fit();
+  ownedMotion.reserve(source.size());
+
+  float dt = periodUs / 1e6f;
+  for (size_t i = 0; i < source.size(); i++) {
+    size_t prev = i > 0 ? i - 1 : i;
+    size_t next = std::min(i + 1, source.size() - 1);
+    float span = (next - prev) * dt;
+    float speed = 0;
+    float turnRate = 0;
+    if (span > 0) {
+      float dx = source[next].x - source[prev].x;
+      float dy = source[next].y - source[prev].y;
+      speed = std::hypot(dx, dy) / span;
+
+      // Moving against the heading (LemLib: 0 = +Y, clockwise) is reversing
+      float headingRad = source[i].theta * M_PI / 180.0f;
+      if (dx * std::sin(headingRad) + dy * std::cos(headingRad) < 0)
+        speed = -speed;
+
+      turnRate =
+          std::remainder(source[next].theta - source[prev].theta, 360.0f) /
+          span;
+    }
+
+    ownedMotion.push_back(
+        {quantize(speed, PLAN_SPEED_STEP), quantize(turnRate, PLAN_TURN_STEP)});
+  }
+}
+
+// ==================== Decoding ====================
+
+GridFrame CompactPlan::operator[](size_t i) const {
+  const PlanFrame &packed = frames[i];
+  GridFrame frame;
+  frame.x = originX + packed.x * PLAN_POSITION_STEP;
+  frame.y = originY + packed.y * PLAN_POSITION_STEP;
+  frame.theta = packed.theta * PLAN_ANGLE_STEP;
+  frame.intakePower = packed.intakePower;
+  frame.outtakePower = packed.outtakePower;
+  frame.toggles = packed.flags & ~(1 << PLAN_ACTION_BIT);
+  frame.hasAction = (packed.flags >> PLAN_ACTION_BIT) & 1;
+  if (placed) {
+    placement.apply(frame.x, frame.y, frame.theta);
+    frame.theta = std::remainder(frame.theta, 360.0f);
+  }
+  return frame;
+}
+
+void CompactPlan::clear() {
+  ownedFrames.clear();
+  ownedFrames.shrink_to_fit();
+  ownedMotion.clear();
+  ownedMotion.shrink_to_fit();
+  useOwned();
+  originX = 0;
+  originY = 0;
+  placement = PlanPlacement();
+  placed = false;
+}
+
+// ==================== Storage ====================
+
+#pragma pack(push, 1)
+struct StoredPlanHeader {
+  uint32_t frameCount;
+  uint32_t periodUs;
+  float originX;
+  float originY;
+};
+#pragma pack(pop)
+
+bool CompactPlan::write(FILE *file, uint32_t &crc) const {
+  StoredPlanHeader header = {static_cast<uint32_t>(count), periodUs, originX,
+                             originY};
+  if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+      fwrite(frames, sizeof(PlanFrame), count, file) != count ||
+      fwrite(motion, sizeof(PlanMotion), count, file) != count) {
+    return false;
+  }
+  crc = crc32(&header, sizeof(header), crc);
+  crc = crc32(frames, count * sizeof(PlanFrame), crc);
+  crc = crc32(motion, count * sizeof(PlanMotion), crc);
+  return true;
+}
+
+bool CompactPlan::read(FILE *file, size_t maxFrames, uint32_t &crc) {
+  StoredPlanHeader header;
+  if (fread(&header, sizeof(header), 1, file) != 1 ||
+      header.frameCount > maxFrames || header.periodUs == 0) {
+    return false;
+  }
+
+  std::vector<PlanFrame> readFrames(header.frameCount);
+  std::vector<PlanMotion> readMotion(header.frameCount);
+  if (fread(readFrames.data(), sizeof(PlanFrame), readFrames.size(), file) !=
+          readFrames.size() ||
+      fread(readMotion.data(), sizeof(PlanMotion), readMotion.size(), file) !=
+          readMotion.size()) {
+    return false;
+  }
+  crc = crc32(&header, sizeof(header), crc);
+  crc = crc32(readFrames.data(), readFrames.size() * sizeof(PlanFrame), crc);
+  crc = crc32(readMotion.data(), readMotion.size() * sizeof(PlanMotion), crc);
+
+  ownedFrames = std::move(readFrames);
+  ownedMotion = std::move(readMotion);
+  useOwned();
+  periodUs = header.periodUs;
+  originX = header.originX;
+  originY = header.originY;
+  placement = PlanPlacement();
+  placed = false;
+  return true;
+}
+
+bool CompactPlan::readInPlace(const uint8_t *&data, const uint8_t *end,
+                              size_t maxFrames, uint32_t &crc) {
+  // Frames are packed (byte-aligned), so they can be used wherever they sit;
+  // only the header is copied out
+  StoredPlanHeader header;
+  if (end - data < static_cast<ptrdiff_t>(sizeof(header)))
+    return false;
+  std::memcpy(&header, data, sizeof(header));
+  if (header.frameCount > maxFrames || header.periodUs == 0)
+    return false;
+  size_t frameBytes = header.frameCount * sizeof(PlanFrame);
+  size_t motionBytes = header.frameCount * sizeof(PlanMotion);
+  if (static_cast<size_t>(end - data) <
+      sizeof(header) + frameBytes + motionBytes) {
+    return false;
+  }
+  const uint8_t *frameData = data + sizeof(header);
+  const uint8_t *motionData = frameData + frameBytes;
+  crc = crc32(data, sizeof(header) + frameBytes + motionBytes, crc);
+  data = motionData + motionBytes;
+
+  ownedFrames.clear();
+  ownedFrames.shrink_to_fit();
+  ownedMotion.clear();
+  ownedMotion.shrink_to_fit();
+  frames = reinterpret_cast<const PlanFrame *>(frameData);
+  motion = reinterpret_cast<const PlanMotion *>(motionData);
+  count = header.frameCount;
+  periodUs = header.periodUs;
+  originX = header.originX;
+  originY = header.originY;
+  placement = PlanPlacement();
+  placed = false;
+  return true;
+}
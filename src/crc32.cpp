@@ -0,0 +1,52 @@
+#include "crc32.h"
+#include <array>
+#include <cstring>
+
+// Slice-by-8 lookup tables built at compile time. Table 0 is the classic
+// byte-at-a-time table; table k advances a byte through k extra zero bytes,
+// which lets the main loop fold in 8 bytes per iteration.
+using CrcTables = std::array<std::array<uint32_t, 256>, 8>;
+
+static constexpr CrcTables makeTables() {
+  CrcTables tables{};
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t c = i;
+    for (int k = 0; k < 8; k++)
+      c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+    tables[0][i] = c;
+  }
+  for (uint32_t i = 0; i < 256; i++) {
+    for (int t = 1; t < 8; t++) {
+      uint32_t prev = tables[t - 1][i];
+      tables[t][i] = (prev >> 8) ^ tables[0][prev & 0xFF];
+    }
+  }
+  return tables;
+}
+
+static constexpr CrcTables CRC_TABLES = makeTables();
+
+uint32_t crc32(const void *data, size_t length, uint32_t crc) {
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  crc = ~crc;
+
+  // 8 bytes per iteration (memcpy keeps unaligned reads safe)
+  while (length >= 8) {
+    uint32_t low, high;
+    std::memcpy(&low, bytes, 4);
+    std::memcpy(&high, bytes + 4, 4);
+    low ^= crc;
+    crc = CRC_TABLES[7][low & 0xFF] ^ CRC_TABLES[6][(low >> 8) & 0xFF] ^
+          CRC_TABLES[5][(low >> 16) & 0xFF] ^ CRC_TABLES[4][low >> 24] ^
+          CRC_TABLES[3][high & 0xFF] ^ CRC_TABLES[2][(high >> 8) & 0xFF] ^
+          CRC_TABLES[1][(high >> 16) & 0xFF] ^ CRC_TABLES[0][high >> 24];
+    bytes += 8;
+    length -= 8;
+  }
+
+  // Remaining tail bytes
+  while (length--) {
+    crc = CRC_TABLES[0][(crc ^ *bytes++) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
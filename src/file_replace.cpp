@@ -0,0 +1,39 @@
+#include "file_replace.h"
+#include <cstdint>
+#include <cstdio>
+
+// If the filesystem can't rename, fall back to copying; the temp file is only
+// removed once the copy succeeded, so there is always one complete file to
+// recover from.
+bool replaceFile(const std::string &from, const std::string &to) {
+  remove(to.c_str());
+  if (rename(from.c_str(), to.c_str()) == 0) {
+    return true;
+  }
+
+  FILE *src = fopen(from.c_str(), "rb");
+  if (!src) {
+    return false;
+  }
+  FILE *dst = fopen(to.c_str(), "wb");
+  if (!dst) {
+    fclose(src);
+    return false;
+  }
+
+  uint8_t buffer[512];
+  bool ok = true;
+  size_t n;
+  while (ok && (n = fread(buffer, 1, sizeof(buffer), src)) > 0) {
+    ok = fwrite(buffer, 1, n, dst) == n;
+  }
+  fclose(src);
+  if (fclose(dst) != 0) {
+    ok = false;
+  }
+
+  if (ok) {
+    remove(from.c_str());
+  }
+  return ok;
+}
@@ -0,0 +1,190 @@
+#include "frame_store.h"
+#include <algorithm>
+#include <cmath>
+
+// ==================== Pool ====================
+
+// Allocated with the program image, so recording never needs the heap
+static FrameChunk frameArena[FRAME_POOL_CHUNKS];
+
+// Global instance
+FramePool framePool(frameArena);
+
+FramePool::FramePool(FrameChunk *arena) : chunks(arena) {
+  for (size_t i = 0; i < FRAME_POOL_CHUNKS; i++) {
+    freeList[i] = FRAME_POOL_CHUNKS - 1 - i;
+  }
+}
+
+FrameChunk *FramePool::acquire() {
+  if (freeCount == 0)
+    return nullptr;
+  return &chunks[freeList[--freeCount]];
+}
+
+void FramePool::release(FrameChunk *chunk) {
+  if (!chunk || freeCount >= FRAME_POOL_CHUNKS)
+    return;
+  freeList[freeCount++] = static_cast<uint8_t>(chunk - chunks);
+}
+
+// ==================== Store ====================
+
+// Step from `last` towards `value` (in units), updating `last` to where the
+// step lands
+static int16_t delta(float value, int32_t &last) {
+  long units = std::lround(value / CAPTURE_POSITION_STEP);
+  long step = std::clamp(units - last, -32767L, 32767L);
+  last += step;
+  return static_cast<int16_t>(step);
+}
+
+FrameStore::FrameStore(FrameStore &&other) : pool(other.pool) {
+  *this = std::move(other);
+}
+
+FrameStore &FrameStore::operator=(FrameStore &&other) {
+  if (this != &other) {
+    clear();
+    pool = other.pool;
+    chunks = other.chunks;
+    buttonChunks = other.buttonChunks;
+    count = other.count;
+    changeCount = other.changeCount;
+    lastX = other.lastX;
+    lastY = other.lastY;
+    lastTime = other.lastTime;
+    lastButtons = other.lastButtons;
+    other.chunks = {};
+    other.buttonChunks = {};
+    other.count = 0;
+    other.changeCount = 0;
+    other.lastX = 0;
+    other.lastY = 0;
+    other.lastTime = 0;
+    other.lastButtons = 0;
+  }
+  return *this;
+}
+
+bool FrameStore::append(const CaptureFrame &frame) {
+  size_t slot = count % FRAME_CHUNK_SIZE;
+  size_t index = count / FRAME_CHUNK_SIZE;
+  if (slot == 0) {
+    if (index >= FRAME_POOL_CHUNKS)
+      return false;
+    chunks[index] = pool->acquire();
+    if (!chunks[index])
+      return false;
+  }
+  chunks[index]->frames[slot] = frame;
+  count++;
+  return true;
+}
+
+bool FrameStore::push_back(const WaypointFrame &frame) {
+  // Room for the button change first, so a full log stores nothing
+  bool buttonsChanged = frame.buttons != lastButtons;
+  if (buttonsChanged && changeCount % BUTTON_CHUNK_SIZE == 0) {
+    size_t index = changeCount / BUTTON_CHUNK_SIZE;
+    if (index >= BUTTON_LOG_CHUNKS)
+      return false;
+    buttonChunks[index] = pool->acquire();
+    if (!buttonChunks[index])
+      return false;
+  }
+
+  CaptureFrame packed;
+  int32_t x = lastX;
+  int32_t y = lastY;
+  packed.dx = delta(frame.x, x);
+  packed.dy = delta(frame.y, y);
+  long angle = std::lround(std::remainder(frame.theta, 360.0f) / CAPTURE_ANGLE_STEP);
+  packed.theta = static_cast<int16_t>(static_cast<uint16_t>(angle));
+  packed.intakePower = frame.intakePower;
+  packed.outtakePower = frame.outtakePower;
+
+  // Deltas are taken between rounded values, so rounding never builds up
+  uint64_t time = (frame.timestamp + CAPTURE_TIME_STEP_US / 2) / CAPTURE_TIME_STEP_US;
+  uint64_t dt = time > lastTime ? time - lastTime : 0;
+  while (dt > UINT16_MAX) {
+    packed.dt = UINT16_MAX;
+    if (!append(packed))
+      return false;
+    lastTime += UINT16_MAX;
+    dt -= UINT16_MAX;
+    // Later copies stay put
+    packed.dx = 0;
+    packed.dy = 0;
+  }
+  packed.dt = static_cast<uint16_t>(dt);
+  if (!append(packed))
+    return false;
+  lastX = x;
+  lastY = y;
+  lastTime += dt;
+
+  if (buttonsChanged) {
+    ButtonChange &entry = buttonChunks[changeCount / BUTTON_CHUNK_SIZE]
+                              ->changes[changeCount % BUTTON_CHUNK_SIZE];
+    entry.frame = static_cast<uint16_t>(count - 1);
+    entry.buttons = frame.buttons;
+    changeCount++;
+    lastButtons = frame.buttons;
+  }
+  return true;
+}
+
+void FrameStore::clear() {
+  for (FrameChunk *&chunk : chunks) {
+    pool->release(chunk);
+    chunk = nullptr;
+  }
+  for (FrameChunk *&chunk : buttonChunks) {
+    pool->release(chunk);
+    chunk = nullptr;
+  }
+  count = 0;
+  changeCount = 0;
+  lastX = 0;
+  lastY = 0;
+  lastTime = 0;
+  lastButtons = 0;
+}
+
+// ==================== Widening ====================
+
+FrameStore::Iterator::Iterator(const FrameStore *store, size_t index)
+    : store(store), index(index) {
+  load();
+}
+
+void FrameStore::Iterator::load() {
+  if (index >= store->count)
+    return;
+  const CaptureFrame &packed = store->frame(index);
+  x += packed.dx;
+  y += packed.dy;
+  time += packed.dt;
+  prevButtons = buttons;
+  if (nextChange < store->changeCount &&
+      store->change(nextChange).frame == index) {
+    buttons = store->change(nextChange).buttons;
+    nextChange++;
+  }
+}
+
+WaypointFrame FrameStore::Iterator::operator*() const {
+  const CaptureFrame &packed = store->frame(index);
+  WaypointFrame frame;
+  frame.x = x * CAPTURE_POSITION_STEP;
+  frame.y = y * CAPTURE_POSITION_STEP;
+  frame.theta = packed.theta * CAPTURE_ANGLE_STEP;
+  frame.timestamp = time * CAPTURE_TIME_STEP_US;
+  frame.intakePower = packed.intakePower;
+  frame.outtakePower = packed.outtakePower;
+  frame.buttons = buttons;
+  frame.hasAction = isActionFrame(buttons, prevButtons, packed.intakePower,
+                                  packed.outtakePower);
+  return frame;
+}
@@ -0,0 +1,55 @@
+#include "idle_trim.h"
+#include <cmath>
+
+IdleTrimReport trimIdle(std::vector<GridFrame> &plan, uint32_t periodUs,
+                        const IdleTrimConfig &config) {
+  IdleTrimReport report;
+  if (plan.size() < 3 || periodUs == 0)
+    return report;
+
+  float dt = periodUs / 1e6f;
+  size_t dwellFrames =
+      (static_cast<uint64_t>(config.minDwellMs) * 1000 + periodUs - 1) /
+      periodUs;
+
+  GridFrame prev = plan[0]; // Untrimmed previous frame
+  GridFrame anchor = plan[0]; // Where the current stretch began
+  size_t idleRun = 0;       // Idle frames so far in the current stretch
+  size_t write = 1;         // Frame 0 is always kept
+
+  for (size_t k = 1; k < plan.size(); k++) {
+    GridFrame frame = plan[k];
+
+    float speed = std::hypot(frame.x - prev.x, frame.y - prev.y) / dt;
+    float turnRate =
+        std::fabs(std::remainder(frame.theta - prev.theta, 360.0f)) / dt;
+    bool quiet = frame.toggles == 0 && !frame.hasAction &&
+                 frame.intakePower == 0 && frame.outtakePower == 0;
+    bool still = speed < config.maxSpeed && turnRate < config.maxTurnRate;
+    bool near =
+        std::hypot(frame.x - anchor.x, frame.y - anchor.y) < config.maxDrift &&
+        std::fabs(std::remainder(frame.theta - anchor.theta, 360.0f)) <
+            config.maxHeadingDrift;
+
+    if (quiet && still && near) {
+      idleRun++;
+    } else {
+      idleRun = 0;
+      anchor = frame;
+    }
+
+    // Keep the dwell and always the final frame (the end pose)
+    if (idleRun <= dwellFrames || k == plan.size() - 1) {
+      plan[write++] = frame;
+    } else {
+      if (idleRun == dwellFrames + 1)
+        report.intervals++;
+      report.removedFrames++;
+    }
+    prev = frame;
+  }
+
+  plan.resize(write);
+  report.secondsSaved = report.removedFrames * dt;
+  return report;
+}
@@ -0,0 +1,24 @@
+#include "loop_timer.h"
+#include "lemlib/util.hpp"
+
+void LoopTimer::wait() {
+  if (nextWake == 0)
+    nextWake = pros::millis();
+  pros::Task::delay_until(&nextWake, periodMs);
+
+  // Wake-to-wake period: work done plus time slept
+  uint64_t now = pros::micros();
+  if (lastWake != 0) {
+    uint32_t period = now - lastWake;
+    stats.avgPeriodMs =
+        stats.iterations == 0
+            ? period / 1000.0f
+            : lemlib::ema(period / 1000.0f, stats.avgPeriodMs, 0.05f);
+    if (period > stats.maxPeriodUs)
+      stats.maxPeriodUs = period;
+    if (period > periodMs * 1500)
+      stats.lateIterations++;
+    stats.iterations++;
+  }
+  lastWake = now;
+}
@@ -5,20 +5,40 @@
 #include <string> // IWYU pragma: keep
 
 
+#include "loop_timer.h"
+#include "motion_chain.h"
+#include "odom_scheduler.h"
 #include "position_replay.h"
+#include "recording_library.h"
+#include "recording_view.h"
+#include "tuning_config.h"
 #include "subsystems/intake.h"
 #include "subsystems/outtake.h"
 #include "subsystems/pneumatics.h"
 
+#ifdef FALLBACK_RECORDING
+// Plan of recordings/fallback.bin, for when the card is missing or its slot
+// is bad
+RECORDING_ASSET(fallback_plan);
+#endif
+
 void initialize() {
   initializeRobot();
 
-  // Try to load any existing recording from SD card
-  if (positionReplay.loadFromSD()) {
-    pros::screen::set_pen(pros::c::COLOR_GREEN);
-    pros::screen::print(pros::E_TEXT_MEDIUM, 10, 100,
-                        "Position recording loaded!");
-  }
+#ifdef FALLBACK_RECORDING
+  positionReplay.setFallbackRecording(fallback_plan);
+#endif
+
+  // Tunables from /usd/tuning.cfg (parsed once; CFG on the menu reloads)
+  tuningFile.load();
+  positionReplay.applyConfig(tuningFile.get());
+
+  // Read the slot catalog (one small file) so the menu can list recordings
+  recordingLibrary.loadCatalog();
+
+  // Load the selected slot's recording in the background so initialize()
+  // returns without waiting on the SD card; the menu redraws when it's done
+  positionReplay.loadFromSDAsync();
 
   drawReplayMenu();
 }
@@ -33,11 +53,46 @@ void disabled() {
   }
 }
 
-void competition_initialize() {}
+// Keep the menu current (the UI side of a background load)
+static void updateMenu(uint32_t &lastLoadDraw);
+
+void competition_initialize() {
+  // Runs while disabled on the field until the match starts, so a slot that
+  // finishes loading here still shows up
+  uint32_t lastLoadDraw = 0;
+  while (true) {
+    updateMenu(lastLoadDraw);
+    pros::delay(20);
+  }
+}
+
+// Hand-planned skills route (jerryio export), run when there's no recording
+ASSET(skills_txt);
 
 void autonomous() {
-  // Play back the recorded position-based autonomous
-  positionReplay.playback();
+  // The selected slot may still be loading from initialize(); a failed or
+  // empty load leaves no frames
+  positionReplay.waitForLoad(1500);
+
+  if (positionReplay.getFrameCount() > 0) {
+    // Play back the recorded position-based autonomous in its own task, so
+    // disabled() can still stop it cleanly (run log saved) when this task is
+    // ended by the field
+    positionReplay.playbackAsync().wait();
+    return;
+  }
+
+  MotionChain skills;
+  if (!skills.loadPath(skills_txt)) {
+    master.print(0, 0, "NO AUTON!          ");
+    return;
+  }
+  // Odometry starts where the path does (LemLib and the fused estimate)
+  lemlib::Pose start(0, 0, 0);
+  if (skills.getStartPose(start)) {
+    odomScheduler.setPose(start);
+  }
+  skills.run();
 }
 
 // Small deadband to prevent drift (applies to values close to 0)
@@ -45,6 +100,32 @@ int applyDeadband(int value, int threshold = 8) {
   return (abs(value) < threshold) ? 0 : value;
 }
 
+// Status area: the loaded recording, or load progress
+static void drawRecordingInfo() {
+  pros::screen::set_pen(pros::c::COLOR_DARK_GRAY);
+  pros::screen::fill_rect(20, 192, 460, 236);
+
+  // Show recording info
+  pros::screen::set_pen(pros::c::COLOR_WHITE);
+  if (positionReplay.isLoading()) {
+    pros::screen::print(pros::E_TEXT_MEDIUM, 30, 197,
+                        "Loading recording... %d%%",
+                        static_cast<int>(positionReplay.getLoadProgress() * 100));
+  } else if (positionReplay.getFrameCount() > 0) {
+    uint32_t duration = positionReplay.getDuration();
+    pros::screen::print(pros::E_TEXT_MEDIUM, 30, 197,
+                        "Recording: %d waypoints (%.1f sec)",
+                        positionReplay.getFrameCount(), duration / 1000.0f);
+  } else {
+    pros::screen::print(pros::E_TEXT_MEDIUM, 30, 197, "No recording loaded");
+  }
+
+  // Instructions
+  pros::screen::set_pen(pros::c::COLOR_YELLOW);
+  pros::screen::print(pros::E_TEXT_SMALL, 30, 218,
+                      "Tap slot (again: PD/RS/MPC), RECORD, STOP");
+}
+
 // Draw the main menu for recording/playback
 void drawReplayMenu() {
   pros::screen::set_pen(pros::c::COLOR_BLACK);
@@ -54,38 +135,79 @@ void drawReplayMenu() {
   pros::screen::set_pen(pros::c::COLOR_WHITE);
   pros::screen::print(pros::E_TEXT_LARGE, 100, 10, "POSITION RECORDER");
 
-  // Draw buttons
-  // Record button (left side)
-  pros::screen::set_pen(pros::c::COLOR_RED);
-  pros::screen::fill_rect(20, 60, 220, 140);
+  // Tuning reload button (top left)
+  pros::screen::set_pen(pros::c::COLOR_PURPLE);
+  pros::screen::fill_rect(10, 10, 85, 45);
   pros::screen::set_pen(pros::c::COLOR_WHITE);
-  pros::screen::print(pros::E_TEXT_LARGE, 70, 90, "RECORD");
+  pros::screen::print(pros::E_TEXT_MEDIUM, 28, 20, "CFG");
 
-  // Playback button (right side)
-  pros::screen::set_pen(pros::c::COLOR_GREEN);
-  pros::screen::fill_rect(260, 60, 460, 140);
-  pros::screen::set_pen(pros::c::COLOR_WHITE);
-  pros::screen::print(pros::E_TEXT_LARGE, 320, 90, "PLAY");
-
-  // Status area
-  pros::screen::set_pen(pros::c::COLOR_DARK_GRAY);
-  pros::screen::fill_rect(20, 160, 460, 220);
+  // Draw buttons
+  // Record button (left side) - STOP while counting down or recording
+  if (positionReplay.isRecording()) {
+    pros::screen::set_pen(pros::c::COLOR_ORANGE);
+    pros::screen::fill_rect(20, 60, 220, 140);
+    pros::screen::set_pen(pros::c::COLOR_WHITE);
+    pros::screen::print(pros::E_TEXT_LARGE, 80, 90, "STOP");
+  } else {
+    pros::screen::set_pen(pros::c::COLOR_RED);
+    pros::screen::fill_rect(20, 60, 220, 140);
+    pros::screen::set_pen(pros::c::COLOR_WHITE);
+    pros::screen::print(pros::E_TEXT_LARGE, 70, 90, "RECORD");
+  }
 
-  // Show recording info
-  pros::screen::set_pen(pros::c::COLOR_WHITE);
-  if (positionReplay.getFrameCount() > 0) {
-    uint32_t duration = positionReplay.getDuration();
-    pros::screen::print(pros::E_TEXT_MEDIUM, 30, 175,
-                        "Recording: %d waypoints (%.1f sec)",
-                        positionReplay.getFrameCount(), duration / 1000.0f);
+  // Playback button (right side) - STOP while playing
+  if (positionReplay.isPlaying()) {
+    pros::screen::set_pen(pros::c::COLOR_ORANGE);
+    pros::screen::fill_rect(260, 60, 460, 140);
+    pros::screen::set_pen(pros::c::COLOR_WHITE);
+    pros::screen::print(pros::E_TEXT_LARGE, 320, 90, "STOP");
   } else {
-    pros::screen::print(pros::E_TEXT_MEDIUM, 30, 175, "No recording loaded");
+    pros::screen::set_pen(pros::c::COLOR_GREEN);
+    pros::screen::fill_rect(260, 60, 460, 140);
+    pros::screen::set_pen(pros::c::COLOR_WHITE);
+    pros::screen::print(pros::E_TEXT_LARGE, 320, 90, "PLAY");
   }
 
-  // Instructions
-  pros::screen::set_pen(pros::c::COLOR_YELLOW);
-  pros::screen::print(pros::E_TEXT_SMALL, 30, 195,
-                      "Touch RECORD, drive, touch STOP when done");
+  // Slot tabs (from the catalog - no recording files are opened here)
+  for (size_t i = 0; i < RecordingLibrary::MAX_SLOTS; i++) {
+    const CatalogEntry &entry = recordingLibrary.getEntry(i);
+    int x0 = 20 + i * 110;
+
+    if (i == recordingLibrary.getActiveSlot()) {
+      pros::screen::set_pen(pros::c::COLOR_BLUE);
+    } else {
+      pros::screen::set_pen(pros::c::COLOR_DIM_GRAY);
+    }
+    pros::screen::fill_rect(x0, 148, x0 + 105, 186);
+
+    pros::screen::set_pen(pros::c::COLOR_WHITE);
+    pros::screen::print(pros::E_TEXT_SMALL, x0 + 5, 152, "%s", entry.name);
+    static const char *const TRACKING_LABELS[] = {"PD", "RS", "MPC"};
+    pros::screen::print(pros::E_TEXT_SMALL, x0 + 76, 152, "%s",
+                        TRACKING_LABELS[entry.tracking]);
+    if (entry.used) {
+      pros::screen::print(pros::E_TEXT_SMALL, x0 + 5, 168, "%.1fs %dpts",
+                          entry.durationMs / 1000.0f, entry.frameCount);
+    } else {
+      pros::screen::print(pros::E_TEXT_SMALL, x0 + 5, 168, "empty");
+    }
+  }
+
+  drawRecordingInfo();
+}
+
+static void updateMenu(uint32_t &lastLoadDraw) {
+  // A finished load redraws everything (slot tabs may have changed too);
+  // while one runs, its progress is redrawn from loadedFrames
+  if (positionReplay.takeMenuRedraw()) {
+    if (!positionReplay.isPlaying()) {
+      drawReplayMenu();
+    }
+  } else if (positionReplay.isLoading() &&
+             pros::millis() - lastLoadDraw >= 250) {
+    lastLoadDraw = pros::millis();
+    drawRecordingInfo();
+  }
 }
 
 // Handle touch input for the menu
@@ -99,66 +221,137 @@ void handleMenuTouch() {
     // Check if in button area (y between 60 and 140)
     if (y >= 60 && y <= 140) {
       // Record button
-      if (x >= 20 && x <= 220) {
+      if (x >= 20 && x <= 220 && !positionReplay.isPlaying()) {
         if (!positionReplay.isRecording()) {
           positionReplay.startRecording();
-
-          // Change button to STOP
-          pros::screen::set_pen(pros::c::COLOR_ORANGE);
-          pros::screen::fill_rect(20, 60, 220, 140);
-          pros::screen::set_pen(pros::c::COLOR_WHITE);
-          pros::screen::print(pros::E_TEXT_LARGE, 80, 90, "STOP");
+          drawReplayMenu(); // Button turns into STOP
         } else {
           positionReplay.stopRecording(true); // Save to SD
           drawReplayMenu();                   // Redraw menu
         }
       }
-      // Play button
-      else if (x >= 260 && x <= 460 && !positionReplay.isRecording()) {
-        positionReplay.playback();
-        drawReplayMenu(); // Redraw after playback
+      // Play button (STOP while a run is in progress)
+      else if (x >= 260 && x <= 460) {
+        if (positionReplay.isPlaying()) {
+          positionReplay.abortPlayback();
+        } else if (!positionReplay.isRecording()) {
+          positionReplay.playbackAsync();
+          drawReplayMenu(); // Button turns into STOP
+        }
       }
     }
+    // Slot tabs
+    else if (y >= 148 && y <= 186 && x >= 20 && x < 460 &&
+             !positionReplay.isRecording() && !positionReplay.isPlaying()) {
+      size_t slot = (x - 20) / 110;
+      if (slot == recordingLibrary.getActiveSlot()) {
+        // Tapping the active slot cycles its tracking law
+        uint8_t next = (recordingLibrary.getEntry(slot).tracking + 1) %
+                       (static_cast<uint8_t>(TrackingMode::Mpc) + 1);
+        recordingLibrary.setSlotTracking(slot, static_cast<TrackingMode>(next));
+      } else {
+        recordingLibrary.selectSlot(slot);
+      }
+      drawReplayMenu();
+    }
+    // Tuning reload - between runs only
+    else if (y >= 10 && y <= 45 && x >= 10 && x <= 85 &&
+             !positionReplay.isRecording() && !positionReplay.isPlaying()) {
+      bool found = tuningFile.load();
+      positionReplay.applyConfig(tuningFile.get());
+      if (found) {
+        master.print(1, 0, "CFG: %d keys %d bad  ", tuningFile.getKeysRead(),
+                     tuningFile.getBadLines());
+      } else {
+        master.print(1, 0, "CFG: DEFAULTS      ");
+      }
+      master.rumble(tuningFile.getBadLines() > 0 ? "-" : ".");
+    }
 
     pros::delay(200); // Debounce
   }
 }
 
+// Playback progress in the status area while a run is in progress
+static void drawPlaybackStatus(const PlaybackHandle &playback) {
+  pros::screen::set_pen(pros::c::COLOR_DARK_GRAY);
+  pros::screen::fill_rect(20, 192, 460, 236);
+  pros::screen::set_pen(pros::c::COLOR_GREEN);
+  pros::screen::fill_rect(20, 230, 20 + playback.progress() * 440, 236);
+  pros::screen::set_pen(pros::c::COLOR_WHITE);
+  pros::screen::print(pros::E_TEXT_MEDIUM, 30, 197,
+                      "Playing %d%%  frame %lu  err %.1fin",
+                      static_cast<int>(playback.progress() * 100),
+                      static_cast<unsigned long>(playback.currentFrame()),
+                      playback.trackingError());
+}
+
+// Loop timing readout under the title (brain screen, no rate limit)
+static void drawLoopStats(const LoopStats &stats, bool saving) {
+  pros::screen::set_pen(pros::c::COLOR_BLACK);
+  pros::screen::fill_rect(100, 44, 340, 58);
+  pros::screen::set_pen(stats.lateIterations > 0 ? pros::c::COLOR_ORANGE
+                                                 : pros::c::COLOR_LIGHT_GRAY);
+  pros::screen::print(pros::E_TEXT_SMALL, 100, 44,
+                      "%sloop %.1fms max %.1fms late %lu",
+                      saving ? "SAVE " : "", stats.avgPeriodMs,
+                      stats.maxPeriodUs / 1000.0f,
+                      static_cast<unsigned long>(stats.lateIterations));
+}
+
 void opcontrol() {
   IntakeControl intake;
   OuttakeControl outtake;
   PneumaticControl pneumatics;
 
+  // 20 ms cadence; stats restart when a save begins so the readout shows
+  // how the loop held up while the SD writer was busy
+  LoopTimer loopTimer(20);
+  bool wasSaving = false;
+  bool wasPlaying = false;
+  uint32_t lastStatsDraw = 0;
+  uint32_t lastPlaybackDraw = 0;
+  uint32_t lastLoadDraw = 0;
+
   while (true) {
     // Handle menu touch
     handleMenuTouch();
+    updateMenu(lastLoadDraw);
 
-    // Tank Drive with deadband
-    int left =
-        applyDeadband(master.get_analog(pros::E_CONTROLLER_ANALOG_LEFT_Y));
-    int right =
-        applyDeadband(master.get_analog(pros::E_CONTROLLER_ANALOG_RIGHT_Y));
-    left_motors.move(left);
-    right_motors.move(right);
+    // The playback task owns the motors and pistons while it runs
+    PlaybackHandle playback = positionReplay.getPlayback();
+    bool playing = playback.isRunning();
+    if (!playing) {
+      // Tank Drive with deadband
+      int deadband = tuningFile.get().driveDeadband;
+      int left = applyDeadband(
+          master.get_analog(pros::E_CONTROLLER_ANALOG_LEFT_Y), deadband);
+      int right = applyDeadband(
+          master.get_analog(pros::E_CONTROLLER_ANALOG_RIGHT_Y), deadband);
+      left_motors.move(left);
+      right_motors.move(right);
 
-    // Update subsystems
-    outtake.update();
-    intake.update(outtake.isMidScoring());
-    pneumatics.update();
+      // Update subsystems
+      outtake.update();
+      intake.update(outtake.isMidScoring());
+      pneumatics.update();
+    } else if (pros::millis() - lastPlaybackDraw >= 250) {
+      lastPlaybackDraw = pros::millis();
+      drawPlaybackStatus(playback);
+    }
+    if (wasPlaying && !playing) {
+      drawReplayMenu(); // PLAY button and recording info back
+    }
+    wasPlaying = playing;
 
-    // Record frame if recording is active
-    positionReplay.recordFrame();
+    // Countdown, frame recording and save reporting (never blocks)
+    positionReplay.update();
 
     // Controller shortcut: UP to start recording, DOWN to stop
     if (master.get_digital_new_press(pros::E_CONTROLLER_DIGITAL_UP)) {
-      if (!positionReplay.isRecording()) {
+      if (!positionReplay.isRecording() && !playing) {
         positionReplay.startRecording();
-
-        // Update screen
-        pros::screen::set_pen(pros::c::COLOR_ORANGE);
-        pros::screen::fill_rect(20, 60, 220, 140);
-        pros::screen::set_pen(pros::c::COLOR_WHITE);
-        pros::screen::print(pros::E_TEXT_LARGE, 80, 90, "STOP");
+        drawReplayMenu();
       }
     }
 
@@ -169,14 +362,44 @@ void opcontrol() {
       }
     }
 
-    // LEFT button to test playback
+    // LEFT button to test playback (again to stop it)
     if (master.get_digital_new_press(pros::E_CONTROLLER_DIGITAL_LEFT)) {
-      if (!positionReplay.isRecording() && !positionReplay.isPlaying()) {
-        positionReplay.playback();
+      if (playing) {
+        playback.cancel();
+      } else if (!positionReplay.isRecording()) {
+        positionReplay.playbackAsync();
         drawReplayMenu();
       }
     }
 
-    pros::delay(20);
+    // RIGHT button toggles mirrored (other side) playback
+    if (master.get_digital_new_press(pros::E_CONTROLLER_DIGITAL_RIGHT)) {
+      if (!positionReplay.isRecording() && !positionReplay.isPlaying()) {
+        RecordingTransform transform = positionReplay.getLoadTransform();
+        transform.mirrorY = !transform.mirrorY;
+        positionReplay.setLoadTransform(transform);
+        master.print(1, 0, "MIRROR: %s         ",
+                     transform.mirrorY ? "ON" : "OFF");
+
+        // Re-read so the transform is applied to untouched frames
+        if (positionReplay.getEmbeddedFile().buf) {
+          positionReplay.loadEmbedded(positionReplay.getEmbeddedFile());
+        } else if (positionReplay.getFrameCount() > 0) {
+          positionReplay.loadFromSDAsync();
+        }
+      }
+    }
+
+    bool saving = positionReplay.isSaving();
+    if (saving && !wasSaving) {
+      loopTimer.resetStats();
+    }
+    wasSaving = saving;
+    if (pros::millis() - lastStatsDraw >= 1000) {
+      lastStatsDraw = pros::millis();
+      drawLoopStats(loopTimer.getStats(), saving);
+    }
+
+    loopTimer.wait();
   }
 }
\ No newline at end of file
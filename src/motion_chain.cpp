@@ -0,0 +1,222 @@
+#include "motion_chain.h"
+#include "robot_config.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// ==================== Helper Functions ====================
+
+float MotionChain::turnAngleAt(size_t index) const {
+  // Last point has nothing to carry into
+  if (index + 1 >= waypoints.size())
+    return 180.0f;
+
+  float prevX = index == 0 ? runStart.x : waypoints[index - 1].x;
+  float prevY = index == 0 ? runStart.y : waypoints[index - 1].y;
+  const ChainWaypoint &here = waypoints[index];
+  const ChainWaypoint &next = waypoints[index + 1];
+
+  float inX = here.x - prevX;
+  float inY = here.y - prevY;
+  float outX = next.x - here.x;
+  float outY = next.y - here.y;
+  float inLen = std::sqrt(inX * inX + inY * inY);
+  float outLen = std::sqrt(outX * outX + outY * outY);
+
+  // Degenerate segment (duplicate point) - treat as a stop
+  if (inLen < 0.01f || outLen < 0.01f)
+    return 180.0f;
+
+  float cosAngle = (inX * outX + inY * outY) / (inLen * outLen);
+  if (cosAngle > 1.0f)
+    cosAngle = 1.0f;
+  if (cosAngle < -1.0f)
+    cosAngle = -1.0f;
+  return std::acos(cosAngle) * 180.0f / M_PI;
+}
+
+float MotionChain::computeCarrySpeed(size_t index) const {
+  const ChainWaypoint &here = waypoints[index];
+
+  // Mechanism actions and the final point need an accurate, settled endpoint
+  if (here.action || index + 1 >= waypoints.size())
+    return 0;
+
+  // Switching between forwards and backwards means a full reversal
+  if (here.forwards != waypoints[index + 1].forwards)
+    return 0;
+
+  float angle = turnAngleAt(index);
+  if (angle >= stopTurnAngle)
+    return 0;
+
+  // cos^2(angle / 2): 1 for a straight pass-through, 0.5 at 90 deg, 0 at 180
+  float half = angle * 0.5f * M_PI / 180.0f;
+  float scale = std::cos(half) * std::cos(half);
+  float speed = maxCarrySpeed * scale;
+
+  // Never carry more speed than either neighbouring motion is allowed
+  if (speed > here.maxSpeed)
+    speed = here.maxSpeed;
+  if (speed > waypoints[index + 1].maxSpeed)
+    speed = waypoints[index + 1].maxSpeed;
+
+  if (speed < minCarrySpeed)
+    return 0;
+  return speed;
+}
+
+float MotionChain::computeExitRange(float carrySpeed) const {
+  if (carrySpeed <= 0)
+    return 0;
+  float range = maxExitRange * carrySpeed / maxCarrySpeed;
+  if (range < minExitRange)
+    range = minExitRange;
+  return range;
+}
+
+// ==================== Route Building ====================
+
+void MotionChain::addWaypoint(const ChainWaypoint &waypoint) {
+  waypoints.push_back(waypoint);
+}
+
+void MotionChain::addWaypoint(float x, float y, float maxSpeed,
+                              bool forwards) {
+  ChainWaypoint waypoint;
+  waypoint.x = x;
+  waypoint.y = y;
+  waypoint.maxSpeed = maxSpeed;
+  waypoint.forwards = forwards;
+  waypoints.push_back(waypoint);
+}
+
+void MotionChain::addAction(std::function<void()> action) {
+  if (waypoints.empty())
+    return;
+  waypoints.back().action = action;
+}
+
+// Position just past the first `key` at or after `from` in unterminated
+// text, or `size` if there isn't one
+static size_t findKey(const char *text, size_t size, const char *key,
+                      size_t from) {
+  size_t keyLen = std::strlen(key);
+  for (; from + keyLen <= size; from++) {
+    if (std::memcmp(text + from, key, keyLen) == 0)
+      return from + keyLen;
+  }
+  return size;
+}
+
+// Number right after the next `key`; `from` moves past it
+static bool findNumber(const char *text, size_t size, const char *key,
+                       size_t &from, float &value) {
+  from = findKey(text, size, key, from);
+  char number[32];
+  size_t len = 0;
+  while (from < size && len < sizeof(number) - 1 &&
+         std::strchr("+-.0123456789eE", text[from]))
+    number[len++] = text[from++];
+  number[len] = '\0';
+  char *end;
+  value = std::strtof(number, &end);
+  return end != number;
+}
+
+// Inches per jerryio unit of length ("uol": mm, cm, m, in, ft)
+static const float JERRYIO_UNITS[] = {1 / 25.4f, 1 / 2.54f, 100 / 2.54f, 1.0f,
+                                      12.0f};
+
+bool MotionChain::loadPath(const asset &path) {
+  const char *text = reinterpret_cast<const char *>(path.buf);
+  size_t pos = 0;
+  size_t loaded = 0;
+
+  // A jerryio export keeps its settings and the path itself after the code;
+  // hand-written files have neither and are in inches
+  float scale = 1.0f;
+  float unit;
+  size_t dataPos = 0;
+  hasPathStart = false;
+  if (findNumber(text, path.size, "\"uol\":", dataPos, unit)) {
+    if (unit < 0 || unit >= sizeof(JERRYIO_UNITS) / sizeof(JERRYIO_UNITS[0]))
+      return false; // A unit we can't convert - don't drive it as inches
+    scale = JERRYIO_UNITS[static_cast<size_t>(unit)];
+
+    // The first control point of the first path is where the robot starts
+    size_t at = findKey(text, path.size, "\"controls\":", dataPos);
+    float x, y, heading;
+    if (findNumber(text, path.size, "\"x\":", at, x) &&
+        findNumber(text, path.size, "\"y\":", at, y) &&
+        findNumber(text, path.size, "\"heading\":", at, heading)) {
+      pathStart = lemlib::Pose(x * scale, y * scale, heading);
+      hasPathStart = true;
+    }
+  }
+
+  while (pos < path.size) {
+    // Copy one line into a terminated buffer (asset data is not terminated)
+    char line[128];
+    size_t len = 0;
+    while (pos < path.size && text[pos] != '\n') {
+      if (len < sizeof(line) - 1)
+        line[len++] = text[pos];
+      pos++;
+    }
+    line[len] = '\0';
+    pos++; // Skip newline
+
+    // Speed is the motion's cap on the usual 0-127 scale
+    float x, y, theta, speed;
+    int fields = std::sscanf(line, " moveToPoint(%f , %f , %f , %f", &x, &y,
+                             &theta, &speed);
+    if (fields >= 2) {
+      float maxSpeed = fields == 4 && speed > 0 ? std::fmin(speed, 127) : 127;
+      addWaypoint(x * scale, y * scale, maxSpeed);
+      loaded++;
+    }
+  }
+
+  return loaded > 0;
+}
+
+void MotionChain::clear() { waypoints.clear(); }
+
+// ==================== Execution ====================
+
+void MotionChain::run() {
+  if (waypoints.empty())
+    return;
+
+  runStart = chassis.getPose();
+  uint32_t startTime = pros::millis();
+
+  for (size_t i = 0; i < waypoints.size(); i++) {
+    const ChainWaypoint &waypoint = waypoints[i];
+    float carrySpeed = computeCarrySpeed(i);
+
+    lemlib::MoveToPointParams params;
+    params.forwards = waypoint.forwards;
+    params.maxSpeed = waypoint.maxSpeed;
+    params.minSpeed = carrySpeed;
+    params.earlyExitRange = computeExitRange(carrySpeed);
+
+    // Async: while a motion is running, LemLib queues this one and blocks
+    // here until the running one exits, so the next motion is always ready
+    // the moment the current one reaches its early exit range.
+    chassis.moveToPoint(waypoint.x, waypoint.y, waypoint.timeout, params,
+                        true);
+
+    if (waypoint.action) {
+      chassis.waitUntilDone();
+      waypoint.action();
+    }
+  }
+
+  chassis.waitUntilDone();
+  lastRunTime = pros::millis() - startTime;
+
+  master.print(0, 0, "CHAIN: %.1f sec     ", lastRunTime / 1000.0f);
+}
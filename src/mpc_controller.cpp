@@ -0,0 +1,268 @@
+#include "mpc_controller.h"
+#include <algorithm>
+#include <cmath>
+
+static constexpr float DEG_TO_RAD = M_PI / 180.0f;
+
+// Index of the effect of du[j] on e[i] (0 <= j < i) in `response`
+static size_t responseIndex(size_t i, size_t j) { return (i - 1) * i / 2 + j; }
+
+static float wrapRadians(float angle) {
+  return std::remainder(angle, 2.0f * static_cast<float>(M_PI));
+}
+
+void MpcController::reset() {
+  warm = false;
+  hasPose = false;
+  leftSpeed = 0;
+  rightSpeed = 0;
+}
+
+size_t MpcController::steps() const {
+  return std::clamp<size_t>(gains.horizon, 1, MAX_HORIZON);
+}
+
+// ==================== Model ====================
+
+void MpcController::buildReference(const CompactPlan &plan, size_t frame,
+                                   size_t n) {
+  // Step k is k ticks ahead; the plan frame nearest that time stands in for
+  // it (frames are much closer together than a tick)
+  float framesPerStep = dt * 1e6f / std::max<uint32_t>(plan.getPeriod(), 1);
+
+  for (size_t k = 0; k <= n; k++) {
+    size_t i = std::min(frame + static_cast<size_t>(k * framesPerStep + 0.5f),
+                        plan.size() - 1);
+    GridFrame target = plan[i];
+    // LemLib headings are clockwise from +Y; the model uses counter-clockwise
+    // from +X like the Ramsete law
+    float turn = -plan.turnRate(i) * DEG_TO_RAD;
+    refX[k] = target.x;
+    refY[k] = target.y;
+    refPhi[k] = (90.0f - target.theta) * DEG_TO_RAD;
+    refSpeed[k] = plan.speed(i);
+    refLeft[k] = refSpeed[k] - turn * gains.trackWidth / 2;
+    refRight[k] = refSpeed[k] + turn * gains.trackWidth / 2;
+  }
+
+  // Power that takes the lagging wheels from one reference speed to the next
+  float lag = std::exp(-dt / gains.timeConstant);
+  float gain = (1 - lag) * gains.maxSpeed;
+  for (size_t k = 0; k < n; k++) {
+    feedforward[k * INPUTS] =
+        std::clamp((refLeft[k + 1] - lag * refLeft[k]) / gain, -1.0f, 1.0f);
+    feedforward[k * INPUTS + 1] =
+        std::clamp((refRight[k + 1] - lag * refRight[k]) / gain, -1.0f, 1.0f);
+  }
+}
+
+void MpcController::rollout(float x, float y, float phi, size_t n) {
+  float lag = std::exp(-dt / gains.timeConstant);
+  float gain = (1 - lag) * gains.maxSpeed;
+
+  // Last tick's powers moved on one step (the final step repeated), or the
+  // plan's feedforward on the first tick
+  for (size_t v = 0; v < n * INPUTS; v++) {
+    float power = feedforward[v];
+    if (warm)
+      power = previous[std::min(v + INPUTS, (n - 1) * INPUTS + v % INPUTS)];
+    nominal[v] = std::clamp(power, -1.0f, 1.0f);
+  }
+
+  float left = leftSpeed;
+  float right = rightSpeed;
+  for (size_t k = 0;; k++) {
+    float *error = &nominalError[k * STATES];
+    error[0] = x - refX[k];
+    error[1] = y - refY[k];
+    error[2] = wrapRadians(phi - refPhi[k]);
+    error[3] = left - refLeft[k];
+    error[4] = right - refRight[k];
+    if (k == n)
+      break;
+
+    float c = std::cos(phi);
+    float s = std::sin(phi);
+    float v = (left + right) / 2;
+    dynamics[k] = {1, 0, -dt * v * s, dt * c / 2, dt * c / 2,
+                   0, 1, dt * v * c,  dt * s / 2, dt * s / 2,
+                   0, 0, 1, -dt / gains.trackWidth, dt / gains.trackWidth,
+                   0, 0, 0, lag, 0,
+                   0, 0, 0, 0, lag};
+
+    x += dt * v * c;
+    y += dt * v * s;
+    phi += dt * (right - left) / gains.trackWidth;
+    left = lag * left + gain * nominal[k * INPUTS];
+    right = lag * right + gain * nominal[k * INPUTS + 1];
+  }
+
+  input = {0, 0, 0, 0, 0, 0, gain, 0, 0, gain};
+}
+
+// ==================== Condensing ====================
+
+void MpcController::condense(size_t n) {
+  const float weight[STATES] = {gains.positionWeight, gains.positionWeight,
+                                gains.headingWeight, gains.speedWeight,
+                                gains.speedWeight};
+
+  // Forced response: G(i, i-1) = B, G(i, j) = A[i-1] G(i-1, j)
+  for (size_t i = 1; i <= n; i++) {
+    const StateMatrix &a = dynamics[i - 1];
+    for (size_t j = 0; j + 1 < i; j++) {
+      const InputMatrix &prev = response[responseIndex(i - 1, j)];
+      InputMatrix &next = response[responseIndex(i, j)];
+      for (size_t r = 0; r < STATES; r++) {
+        for (size_t u = 0; u < INPUTS; u++) {
+          float sum = 0;
+          for (size_t c = 0; c < STATES; c++)
+            sum += a[r * STATES + c] * prev[c * INPUTS + u];
+          next[r * INPUTS + u] = sum;
+        }
+      }
+    }
+    response[responseIndex(i, i - 1)] = input;
+  }
+
+  // H = G'QG + R and f = G'Q e + R (u - u_ff) for the nominal trajectory's
+  // error e, one triangle of H then mirrored
+  size_t vars = n * INPUTS;
+  for (size_t j = 0; j < n; j++) {
+    for (size_t l = 0; l <= j; l++) {
+      float block[INPUTS][INPUTS] = {};
+      for (size_t i = j + 1; i <= n; i++) {
+        const InputMatrix &gj = response[responseIndex(i, j)];
+        const InputMatrix &gl = response[responseIndex(i, l)];
+        for (size_t r = 0; r < STATES; r++) {
+          for (size_t a = 0; a < INPUTS; a++) {
+            float qa = weight[r] * gj[r * INPUTS + a];
+            for (size_t b = 0; b < INPUTS; b++)
+              block[a][b] += qa * gl[r * INPUTS + b];
+          }
+        }
+      }
+      for (size_t a = 0; a < INPUTS; a++) {
+        for (size_t b = 0; b < INPUTS; b++) {
+          float value = block[a][b];
+          if (j == l && a == b)
+            value += gains.inputWeight;
+          hessian[(j * INPUTS + a) * vars + l * INPUTS + b] = value;
+          hessian[(l * INPUTS + b) * vars + j * INPUTS + a] = value;
+        }
+      }
+    }
+
+    for (size_t a = 0; a < INPUTS; a++) {
+      size_t v = j * INPUTS + a;
+      float sum = gains.inputWeight * (nominal[v] - feedforward[v]);
+      for (size_t i = j + 1; i <= n; i++) {
+        const InputMatrix &g = response[responseIndex(i, j)];
+        const float *e = &nominalError[i * STATES];
+        for (size_t r = 0; r < STATES; r++)
+          sum += g[r * INPUTS + a] * weight[r] * e[r];
+      }
+      linear[v] = sum;
+    }
+  }
+
+  // Full power either way is the box; du is relative to the nominal powers
+  for (size_t v = 0; v < vars; v++) {
+    lower[v] = -1 - nominal[v];
+    upper[v] = 1 - nominal[v];
+  }
+}
+
+// ==================== Solver ====================
+
+void MpcController::solve(size_t n) {
+  size_t vars = n * INPUTS;
+
+  // Step size from a Gershgorin bound on the largest eigenvalue of H
+  float lipschitz = 0;
+  for (size_t r = 0; r < vars; r++) {
+    float row = 0;
+    for (size_t c = 0; c < vars; c++)
+      row += std::fabs(hessian[r * vars + c]);
+    lipschitz = std::max(lipschitz, row);
+  }
+  float step = 1.0f / std::max(lipschitz, 1e-6f);
+
+  // Start from the nominal powers themselves (already the warm start)
+  std::fill(solution.begin(), solution.begin() + vars, 0.0f);
+  std::fill(momentum.begin(), momentum.begin() + vars, 0.0f);
+
+  // Accelerated projected gradient (FISTA) with a fixed iteration budget
+  float t = 1;
+  for (uint32_t it = 0; it < gains.iterations; it++) {
+    float tNext = (1 + std::sqrt(1 + 4 * t * t)) / 2;
+    float beta = (t - 1) / tNext;
+    for (size_t r = 0; r < vars; r++) {
+      float gradient = linear[r];
+      const float *row = &hessian[r * vars];
+      for (size_t c = 0; c < vars; c++)
+        gradient += row[c] * momentum[c];
+      projected[r] =
+          std::clamp(momentum[r] - step * gradient, lower[r], upper[r]);
+    }
+    for (size_t r = 0; r < vars; r++) {
+      float next = projected[r];
+      momentum[r] = next + beta * (next - solution[r]);
+      solution[r] = next;
+    }
+    t = tNext;
+  }
+
+  // Keep the absolute powers for the next tick's nominal
+  for (size_t v = 0; v < vars; v++)
+    previous[v] = nominal[v] + solution[v];
+  warm = true;
+}
+
+// ==================== Update ====================
+
+void MpcController::observe(float x, float y, float phi) {
+  if (hasPose) {
+    // Wheel speeds implied by the pose change over the last step
+    float heading = phi - wrapRadians(phi - lastPhi) / 2; // Mid-step
+    float speed = ((x - lastX) * std::cos(heading) +
+                   (y - lastY) * std::sin(heading)) /
+                  dt;
+    float turn = wrapRadians(phi - lastPhi) / dt;
+    float measuredLeft = speed - turn * gains.trackWidth / 2;
+    float measuredRight = speed + turn * gains.trackWidth / 2;
+    leftSpeed += gains.observerGain * (measuredLeft - leftSpeed);
+    rightSpeed += gains.observerGain * (measuredRight - rightSpeed);
+  }
+  lastX = x;
+  lastY = y;
+  lastPhi = phi;
+  hasPose = true;
+}
+
+DriveCommand MpcController::update(const CompactPlan &plan, size_t frame,
+                                   float x, float y, float theta,
+                                   float periodMs) {
+  if (plan.empty())
+    return {0, 0};
+
+  dt = std::max(periodMs, 1.0f) / 1000.0f;
+
+  size_t n = steps();
+  float phi = (90.0f - theta) * DEG_TO_RAD;
+  observe(x, y, phi);
+  buildReference(plan, frame, n);
+  rollout(x, y, phi, n);
+  condense(n);
+  solve(n);
+
+  float left = std::clamp(previous[0], -1.0f, 1.0f);
+  float right = std::clamp(previous[1], -1.0f, 1.0f);
+
+  // Advance the wheel speed model by the command about to be applied
+  float lag = std::exp(-dt / gains.timeConstant);
+  leftSpeed = lag * leftSpeed + (1 - lag) * gains.maxSpeed * left;
+  rightSpeed = lag * rightSpeed + (1 - lag) * gains.maxSpeed * right;
+
+  return {(left + right) / 2 * 127, (left - right) / 2 * 127};
+}
@@ -0,0 +1,98 @@
+#include "odom_fusion.h"
+#include <cmath>
+
+static constexpr float DEG_TO_RAD = M_PI / 180.0f;
+static constexpr float RAD_TO_DEG = 180.0f / M_PI;
+
+void OdomFusion::step(const OdomFusionInput &input) {
+  // First readings only set the reference
+  if (!hasPrev) {
+    prev = input;
+    hasPrev = true;
+    return;
+  }
+
+  float dWheel = input.verticalWheel - prev.verticalWheel;
+  float dLeft = input.leftDrive - prev.leftDrive;
+  float dRight = input.rightDrive - prev.rightDrive;
+
+  // --- Heading ---
+  // Encoder heading: turning clockwise drives the left side forward
+  float dThetaEncoder = (dLeft - dRight) / config.trackWidth * RAD_TO_DEG;
+  float dTheta = dThetaEncoder;
+  bool imuValid = !std::isnan(input.imuRotation) && !std::isnan(prev.imuRotation);
+  if (imuValid) {
+    float dThetaImu = input.imuRotation - prev.imuRotation;
+    dTheta = config.imuWeight * dThetaImu +
+             (1.0f - config.imuWeight) * dThetaEncoder;
+  }
+  float dThetaRad = dTheta * DEG_TO_RAD;
+
+  // --- Forward travel at the tracking center ---
+  // Undo the wheel's arc around the tracking center so both sources agree
+  float wheelCenter = dWheel - config.wheelOffset * dThetaRad;
+  float driveCenter = (dLeft + dRight) * 0.5f;
+  float forward;
+  if (std::fabs(wheelCenter - driveCenter) > config.slipThreshold) {
+    disagreeSteps++;
+    if (disagreeSteps >= 2) {
+      // Sustained disagreement - the drive is slipping (or being pushed):
+      // trust the unpowered wheel, and take back what the first step
+      // wrongly credited to the drive
+      forward = wheelCenter - pendingExcess;
+      pendingExcess = 0;
+      slipSteps++;
+    } else {
+      // Could be a one-off wheel bounce: trust the drive for now
+      forward = driveCenter;
+      pendingExcess = driveCenter - wheelCenter;
+    }
+  } else {
+    disagreeSteps = 0;
+    pendingExcess = 0;
+    forward = config.wheelWeight * wheelCenter +
+              (1.0f - config.wheelWeight) * driveCenter;
+  }
+
+  // --- Integrate (arc approximation, like LemLib) ---
+  float chord = forward;
+  if (std::fabs(dThetaRad) > 1e-6f) {
+    chord = 2.0f * std::sin(dThetaRad * 0.5f) * (forward / dThetaRad);
+  }
+  float avgHeading = (pose.theta + dTheta * 0.5f) * DEG_TO_RAD;
+  float dx = chord * std::sin(avgHeading);
+  float dy = chord * std::cos(avgHeading);
+  pose.x += dx;
+  pose.y += dy;
+  pose.theta += dTheta;
+
+  if (input.dt > 0) {
+    speedX = dx / input.dt;
+    speedY = dy / input.dt;
+    speedTheta = dTheta / input.dt;
+  }
+
+  prev = input;
+}
+
+void OdomFusion::setPose(const FusedPose &newPose) {
+  pose = newPose;
+  speedX = 0;
+  speedY = 0;
+  speedTheta = 0;
+}
+
+void OdomFusion::restart(const FusedPose &newPose) {
+  setPose(newPose);
+  hasPrev = false;
+  disagreeSteps = 0;
+  pendingExcess = 0;
+}
+
+FusedPose OdomFusion::predict(float seconds) const {
+  FusedPose predicted = pose;
+  predicted.x += speedX * seconds;
+  predicted.y += speedY * seconds;
+  predicted.theta += speedTheta * seconds;
+  return predicted;
+}
@@ -0,0 +1,190 @@
+#include "odom_scheduler.h"
+#include "lemlib/chassis/odom.hpp"
+#include "robot_config.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <mutex>
+
+// Global instance
+OdomScheduler odomScheduler;
+
+// V5 smart sensors can't report faster than this
+static constexpr uint32_t MIN_PERIOD_MS = 5;
+
+// Tick lemlib::update() divides by when it works out the speed
+static constexpr float LEMLIB_PERIOD_MS = 10.0f;
+
+void OdomScheduler::start() {
+  if (task)
+    return;
+
+  // Same sensor setup chassis.calibrate(false) does, minus lemlib::init():
+  // LemLib needs a second vertical wheel, so the right drive motors fill in
+  lemlib::OdomSensors odomSensors = sensors;
+  if (!odomSensors.vertical2) {
+    odomSensors.vertical2 = &right_drive_wheel;
+  }
+  odomSensors.vertical1->reset();
+  odomSensors.vertical2->reset();
+  lemlib::setSensors(odomSensors, drivetrain);
+
+  // Have the sensors refresh as often as we read them
+  rotation_sensor.set_data_rate(periodMs);
+  imu.set_data_rate(periodMs);
+
+  task = new pros::Task([this]() { run(); }, priority,
+                        TASK_STACK_DEPTH_DEFAULT, "odom scheduler");
+}
+
+void OdomScheduler::setPeriod(uint32_t ms) {
+  periodMs = std::max(ms, MIN_PERIOD_MS);
+  if (task) {
+    rotation_sensor.set_data_rate(periodMs);
+    imu.set_data_rate(periodMs);
+  }
+  resetStats();
+}
+
+void OdomScheduler::setPriority(uint32_t taskPriority) {
+  priority = taskPriority;
+  if (task) {
+    task->set_priority(priority);
+  }
+}
+
+void OdomScheduler::setFusionEnabled(bool enabled) {
+  std::lock_guard<pros::Mutex> lock(mutex);
+  if (enabled && !fusionEnabled) {
+    lemlib::Pose pose = chassis.getPose();
+    fusion.restart({pose.x, pose.y, pose.theta});
+  }
+  fusionEnabled = enabled;
+}
+
+void OdomScheduler::setFusionConfig(const OdomFusionConfig &config) {
+  std::lock_guard<pros::Mutex> lock(mutex);
+  fusion.setConfig(config);
+}
+
+void OdomScheduler::setPose(const lemlib::Pose &pose) {
+  chassis.setPose(pose);
+  std::lock_guard<pros::Mutex> lock(mutex);
+  fusion.setPose({pose.x, pose.y, pose.theta});
+}
+
+lemlib::Pose OdomScheduler::getFusedPose(float horizon) const {
+  std::lock_guard<pros::Mutex> lock(mutex);
+  FusedPose pose = horizon > 0 ? fusion.predict(horizon) : fusion.getPose();
+  return lemlib::Pose(pose.x, pose.y, pose.theta);
+}
+
+uint32_t OdomScheduler::getSlipSteps() const {
+  std::lock_guard<pros::Mutex> lock(mutex);
+  return fusion.getSlipSteps();
+}
+
+OdomStats OdomScheduler::getStats() const {
+  std::lock_guard<pros::Mutex> lock(mutex);
+  return stats;
+}
+
+OdomSample OdomScheduler::getLatestSample() const {
+  std::lock_guard<pros::Mutex> lock(mutex);
+  return latestSample;
+}
+
+lemlib::Pose OdomScheduler::estimatePose(float horizon) const {
+  // LemLib extrapolates by speed * time, and its speed is off by
+  // LEMLIB_PERIOD_MS / periodMs, so scaling the time cancels it
+  return lemlib::estimatePose(horizon * periodMs / LEMLIB_PERIOD_MS);
+}
+
+void OdomScheduler::stepFusion(uint64_t now, uint64_t &lastStep) {
+  OdomFusionInput input;
+  input.verticalWheel = vertical_tracking_wheel.getDistanceTraveled();
+  input.leftDrive = left_drive_wheel.getDistanceTraveled();
+  input.rightDrive = right_drive_wheel.getDistanceTraveled();
+
+  // Reuse this tick's batched IMU read when there is one
+  double rotation = batchSensorReads ? latestSample.imuRotation
+                                     : imu.get_rotation();
+  input.imuRotation = std::isfinite(rotation) ? rotation : NAN;
+
+  input.dt = lastStep != 0 ? (now - lastStep) / 1e6f : 0;
+  lastStep = now;
+
+  // Sensors are read above, outside the lock
+  std::lock_guard<pros::Mutex> lock(mutex);
+  fusion.step(input);
+}
+
+void OdomScheduler::run() {
+  uint32_t wakeTime = pros::millis();
+  uint64_t lastTickStart = 0;
+  uint64_t lastFusionStep = 0;
+  uint64_t windowStart = pros::micros();
+  uint32_t windowUpdates = 0;
+
+  while (true) {
+    uint64_t tickStart = pros::micros();
+
+    if (resetRequested) {
+      std::lock_guard<pros::Mutex> lock(mutex);
+      stats = OdomStats();
+      windowStart = tickStart;
+      windowUpdates = 0;
+      lastTickStart = 0;
+      resetRequested = false;
+    }
+
+    // Jitter: how far this tick started from one period after the last
+    uint32_t jitter = 0;
+    if (lastTickStart != 0) {
+      int64_t period = tickStart - lastTickStart;
+      jitter = std::abs(period - int64_t(periodMs) * 1000);
+    }
+    lastTickStart = tickStart;
+
+    // Batched read: one read of each sensor per tick, shared via
+    // getLatestSample() so other consumers don't issue their own
+    bool stale = false;
+    if (batchSensorReads) {
+      OdomSample sample;
+      sample.rotationPosition = rotation_sensor.get_position();
+      sample.imuRotation = imu.get_rotation();
+      sample.timestamp = tickStart;
+      stale = sample.rotationPosition == latestSample.rotationPosition &&
+              sample.imuRotation == latestSample.imuRotation;
+      std::lock_guard<pros::Mutex> lock(mutex);
+      latestSample = sample;
+    }
+
+    lemlib::update();
+    if (fusionEnabled) {
+      stepFusion(tickStart, lastFusionStep);
+    }
+
+    // Per-tick cost, published with the rest of this tick's stats
+    uint32_t cost = pros::micros() - tickStart;
+    windowUpdates++;
+    uint64_t windowLength = tickStart - windowStart;
+    {
+      std::lock_guard<pros::Mutex> lock(mutex);
+      stats.maxJitterUs = std::max(stats.maxJitterUs, jitter);
+      stats.staleTicks += stale;
+      stats.avgCostUs = lemlib::ema(cost, stats.avgCostUs, 0.05f);
+      stats.maxCostUs = std::max(stats.maxCostUs, cost);
+      stats.updates++;
+
+      // Update rate over a 1 second window
+      if (windowLength >= 1000000) {
+        stats.rateHz = windowUpdates * 1e6f / windowLength;
+        windowStart = tickStart;
+        windowUpdates = 0;
+      }
+    }
+
+    pros::Task::delay_until(&wakeTime, periodMs);
+  }
+}
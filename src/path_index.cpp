@@ -0,0 +1,68 @@
+#include "path_index.h"
+#include <algorithm>
+#include <cmath>
+
+void PathIndex::build(const CompactPlan &plan, float cellSize) {
+  this->plan = &plan;
+  std::vector<GridPoint> points;
+  points.reserve(plan.size());
+  for (size_t k = 0; k < plan.size(); k++) {
+    GridFrame frame = plan[k];
+    points.push_back({frame.x, frame.y});
+  }
+  grid.build(points, std::max(cellSize, 0.5f));
+}
+
+bool PathIndex::nearest(float x, float y, size_t first, size_t last,
+                        float maxDistance, size_t &frame,
+                        float &distance) const {
+  if (!plan || grid.empty() || first > last)
+    return false;
+
+  int cx = grid.col(x);
+  int cy = grid.row(y);
+  int maxRing = std::max({cx, grid.getCols() - 1 - cx, cy,
+                          grid.getRows() - 1 - cy});
+
+  float best = maxDistance;
+  bool found = false;
+  for (int ring = 0; ring <= maxRing; ring++) {
+    // Every cell in this ring is at least (ring - 1) cells away
+    if (ring > 0 && (ring - 1) * grid.cellSize() > best)
+      break;
+
+    for (int row = cy - ring; row <= cy + ring; row++) {
+      // Whole rows at the top and bottom of the ring, the two ends otherwise
+      bool edge = row == cy - ring || row == cy + ring;
+      int step = edge ? 1 : std::max(2 * ring, 1);
+      for (int col = cx - ring; col <= cx + ring; col += step) {
+        SpatialGrid::Cell cell = grid.cell(col, row);
+        const uint32_t *k = std::lower_bound(cell.begin(), cell.end(), first);
+        for (; k != cell.end() && *k <= last; k++) {
+          GridFrame candidate = (*plan)[*k];
+          float d = std::hypot(candidate.x - x, candidate.y - y);
+          if (d <= best) {
+            best = d;
+            frame = *k;
+            found = true;
+          }
+        }
+      }
+    }
+  }
+
+  if (found)
+    distance = best;
+  return found;
+}
+
+bool PathIndex::rejoin(float x, float y, size_t first, size_t last,
+                       float offPath, float targetDistance,
+                       size_t &frame) const {
+  // Only frames under half the target distance are worth jumping to, so
+  // nothing farther needs searching
+  float distance;
+  return targetDistance > 2 * offPath &&
+         nearest(x, y, first, last, targetDistance / 2, frame, distance) &&
+         distance > offPath;
+}
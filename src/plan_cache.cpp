@@ -0,0 +1,185 @@
+#include "plan_cache.h"
+#include "crc32.h"
+#include "file_replace.h"
+#include <cstdio>
+#include <cstring>
+
+// On-card form of the key (fixed layout, no padding)
+#pragma pack(push, 1)
+struct StoredPlanKey {
+  uint32_t recordingChecksum;
+  uint32_t sourceFrames;
+  uint32_t periodUs;
+  uint32_t nominalIntervalUs;
+  uint32_t trimEnabled;
+  float maxSpeed;
+  float maxTurnRate;
+  float maxDrift;
+  float maxHeadingDrift;
+  uint32_t minDwellMs;
+};
+#pragma pack(pop)
+
+static StoredPlanKey storedKey(const PlanCacheKey &key) {
+  return {key.recordingChecksum, key.sourceFrames,     key.periodUs,
+          key.nominalIntervalUs, key.trimEnabled,      key.trim.maxSpeed,
+          key.trim.maxTurnRate,  key.trim.maxDrift,    key.trim.maxHeadingDrift,
+          key.trim.minDwellMs};
+}
+
+static PlanCacheKey keyFrom(const StoredPlanKey &stored) {
+  PlanCacheKey key;
+  key.recordingChecksum = stored.recordingChecksum;
+  key.sourceFrames = stored.sourceFrames;
+  key.periodUs = stored.periodUs;
+  key.nominalIntervalUs = stored.nominalIntervalUs;
+  key.trimEnabled = stored.trimEnabled != 0;
+  key.trim.maxSpeed = stored.maxSpeed;
+  key.trim.maxTurnRate = stored.maxTurnRate;
+  key.trim.maxDrift = stored.maxDrift;
+  key.trim.maxHeadingDrift = stored.maxHeadingDrift;
+  key.trim.minDwellMs = stored.minDwellMs;
+  return key;
+}
+
+bool PlanCacheKey::operator==(const PlanCacheKey &other) const {
+  StoredPlanKey a = storedKey(*this);
+  StoredPlanKey b = storedKey(other);
+  return std::memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+std::string planCachePath(const std::string &recordingPath) {
+  size_t dot = recordingPath.rfind('.');
+  size_t slash = recordingPath.rfind('/');
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    return recordingPath + ".plan";
+  return recordingPath.substr(0, dot) + ".plan";
+}
+
+// ==================== File Writing ====================
+
+// Layout: magic, version, key, start info, resample report, trim report,
+// plan, CRC-32
+bool writePlanCache(const std::string &path, const PlanCacheKey &key,
+                    const RecordingStartInfo &start, const CompactPlan &plan,
+                    const ResampleReport &resample,
+                    const IdleTrimReport &trim) {
+  std::string tempPath = path + ".tmp";
+  FILE *file = fopen(tempPath.c_str(), "wb");
+  if (!file) {
+    return false;
+  }
+
+  uint32_t header[2] = {PLAN_CACHE_MAGIC, PLAN_CACHE_VERSION};
+  StoredPlanKey stored = storedKey(key);
+  bool ok = fwrite(header, sizeof(header), 1, file) == 1 &&
+            fwrite(&stored, sizeof(stored), 1, file) == 1 &&
+            fwrite(&start, sizeof(start), 1, file) == 1 &&
+            fwrite(&resample, sizeof(resample), 1, file) == 1 &&
+            fwrite(&trim, sizeof(trim), 1, file) == 1;
+  uint32_t crc = crc32(header, sizeof(header));
+  crc = crc32(&stored, sizeof(stored), crc);
+  crc = crc32(&start, sizeof(start), crc);
+  crc = crc32(&resample, sizeof(resample), crc);
+  crc = crc32(&trim, sizeof(trim), crc);
+
+  ok = ok && plan.write(file, crc);
+  ok = ok && fwrite(&crc, sizeof(crc), 1, file) == 1;
+  if (fclose(file) != 0) {
+    ok = false;
+  }
+
+  if (!ok || !replaceFile(tempPath, path)) {
+    remove(tempPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+// ==================== File Reading ====================
+
+bool readPlanCache(const std::string &path, const PlanCacheKey &key,
+                   size_t maxFrames, CachedPlan &out) {
+  FILE *file = fopen(path.c_str(), "rb");
+  if (!file) {
+    return false;
+  }
+
+  // The key is checked before anything big is read
+  uint32_t header[2];
+  StoredPlanKey stored;
+  StoredPlanKey expected = storedKey(key);
+  if (fread(header, sizeof(header), 1, file) != 1 ||
+      header[0] != PLAN_CACHE_MAGIC || header[1] != PLAN_CACHE_VERSION ||
+      fread(&stored, sizeof(stored), 1, file) != 1 ||
+      std::memcmp(&stored, &expected, sizeof(stored)) != 0) {
+    fclose(file);
+    return false;
+  }
+
+  CachedPlan loaded;
+  uint32_t crc = crc32(header, sizeof(header));
+  crc = crc32(&stored, sizeof(stored), crc);
+  bool ok = fread(&loaded.start, sizeof(loaded.start), 1, file) == 1 &&
+            fread(&loaded.resample, sizeof(loaded.resample), 1, file) == 1 &&
+            fread(&loaded.trim, sizeof(loaded.trim), 1, file) == 1;
+  crc = crc32(&loaded.start, sizeof(loaded.start), crc);
+  crc = crc32(&loaded.resample, sizeof(loaded.resample), crc);
+  crc = crc32(&loaded.trim, sizeof(loaded.trim), crc);
+
+  uint32_t storedCrc;
+  ok = ok && loaded.plan.read(file, maxFrames, crc) &&
+       fread(&storedCrc, sizeof(storedCrc), 1, file) == 1 && storedCrc == crc;
+  fclose(file);
+  if (!ok) {
+    return false;
+  }
+
+  out = std::move(loaded);
+  return true;
+}
+
+// ==================== In Place ====================
+
+bool readPlanInPlace(const uint8_t *data, size_t size, size_t maxFrames,
+                     PlanCacheKey &key, CachedPlan &out) {
+  const uint8_t *file = data;
+  const uint8_t *end = data + size;
+  uint32_t header[2];
+  StoredPlanKey stored;
+  CachedPlan loaded;
+  size_t fixedSize = sizeof(header) + sizeof(stored) + sizeof(loaded.start) +
+                     sizeof(loaded.resample) + sizeof(loaded.trim);
+  if (size < fixedSize + sizeof(uint32_t)) {
+    return false;
+  }
+
+  // Everything but the frames is small and copied out; the frames stay put
+  std::memcpy(header, data, sizeof(header));
+  data += sizeof(header);
+  std::memcpy(&stored, data, sizeof(stored));
+  data += sizeof(stored);
+  std::memcpy(&loaded.start, data, sizeof(loaded.start));
+  data += sizeof(loaded.start);
+  std::memcpy(&loaded.resample, data, sizeof(loaded.resample));
+  data += sizeof(loaded.resample);
+  std::memcpy(&loaded.trim, data, sizeof(loaded.trim));
+  data += sizeof(loaded.trim);
+  if (header[0] != PLAN_CACHE_MAGIC || header[1] != PLAN_CACHE_VERSION) {
+    return false;
+  }
+
+  uint32_t crc = crc32(file, fixedSize);
+  uint32_t storedCrc;
+  if (!loaded.plan.readInPlace(data, end - sizeof(storedCrc), maxFrames, crc)) {
+    return false;
+  }
+  std::memcpy(&storedCrc, data, sizeof(storedCrc));
+  if (storedCrc != crc) {
+    return false;
+  }
+
+  key = keyFrom(stored);
+  out = std::move(loaded);
+  return true;
+}
@@ -1,7 +1,15 @@
 #include "position_replay.h"
+#include "crc32.h"
+#include "lemlib/chassis/odom.hpp"
+#include "odom_scheduler.h"
+#include "plan_cache.h"
+#include "recording_library.h"
 #include "robot_config.h"
+#include "sd_writer.h"
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
+#include <mutex>
 
 
 // Global instance
@@ -61,63 +69,117 @@ void PositionReplay::displayCountdown(int secondsRemaining) {
   master.rumble(".");
 }
 
-void PositionReplay::abortPlayback() { _abortRequested = true; }
+lemlib::Pose PositionReplay::readPose(float horizonMs) {
+  if (poseSource == PoseSource::Fused) {
+    return odomScheduler.getFusedPose(horizonMs / 1000.0f);
+  }
+  if (horizonMs > 0) {
+    return odomScheduler.estimatePose(horizonMs / 1000.0f);
+  }
+  return chassis.getPose();
+}
 
-size_t PositionReplay::findFrameIndexAtTime(uint64_t elapsedMicros) {
-  if (recording.empty())
-    return 0;
-  if (elapsedMicros >= recording.back().timestamp)
-    return recording.size() - 1;
-
-  // Binary search
-  size_t lo = 0, hi = recording.size() - 1;
-  while (lo < hi) {
-    size_t mid = lo + (hi - lo) / 2;
-    if (recording[mid].timestamp < elapsedMicros) {
-      lo = mid + 1;
-    } else {
-      hi = mid;
-    }
+void PositionReplay::setPoseSource(PoseSource source) {
+  // A fused pose that isn't being stepped would stay frozen
+  if (source == PoseSource::Fused) {
+    odomScheduler.setFusionEnabled(true);
   }
-  return lo;
+  poseSource = source;
+}
+
+void PositionReplay::resetPose(const lemlib::Pose &pose) {
+  // Keeps LemLib and the fused estimate in the same frame
+  odomScheduler.setPose(pose);
+}
+
+void PositionReplay::abortPlayback() {
+  if (!_isPlaying || _abortRequested)
+    return;
+  abortRequestTime = static_cast<uint32_t>(pros::micros());
+  _abortRequested = true;
+
+  // Wake the loop now instead of at the end of its 20 ms sleep
+  std::lock_guard<pros::Mutex> lock(playbackTaskMutex);
+  if (playbackTask) {
+    pros::c::task_notify(playbackTask);
+  }
+}
+
+size_t PositionReplay::findFrameIndexAtTime(uint64_t elapsedMicros) const {
+  if (plan.empty())
+    return 0;
+
+  // First grid point at or after the elapsed time (the target leads the
+  // clock by under one period, as the old timestamp search did)
+  size_t idx = (elapsedMicros + planPeriodUs - 1) / planPeriodUs;
+  return std::min(idx, plan.size() - 1);
+}
+
+void PositionReplay::updateCatalogEntry() {
+  recordingLibrary.updateActiveSlot(getFrameCount(), getDuration(),
+                                    recordingChecksum, recordingStartPose.x,
+                                    recordingStartPose.y,
+                                    recordingStartPose.theta);
 }
 
 // ==================== Recording ====================
 
 void PositionReplay::startRecording() {
-  // Check SD card
-  if (!isSDCardInserted()) {
-    master.print(0, 0, "WARNING: No SD Card!");
-    master.rumble("---");
-    pros::delay(1000);
-    master.print(0, 0, "Recording anyway...");
+  // The playback task is reading the frames
+  if (_isPlaying) {
+    return;
   }
 
-  // Countdown
-  if (countdownDuration > 0) {
-    int seconds = countdownDuration / 1000;
-    for (int i = seconds; i > 0; i--) {
-      displayCountdown(i);
-      pros::delay(1000);
-    }
+  // The recording buffer belongs to the load task until it finishes
+  if (isLoading()) {
+    master.print(0, 0, "LOADING - WAIT...  ");
+    master.rumble("-");
+    return;
   }
 
-  recording.clear();
+  // ...and to the save task while the last recording is being written
+  if (recordState != RecordState::Idle) {
+    if (isSaving()) {
+      master.print(0, 0, "SAVING - WAIT...   ");
+      master.rumble("-");
+    }
+    return;
+  }
 
-  // Reserve memory (~3 minutes at 10 samples/sec = ~1800 frames)
-  try {
-    recording.reserve(2000);
-  } catch (...) {
-    master.print(0, 0, "MEM RESERVE FAILED!");
+  // Check SD card (warn, but keep going - the driver still has control)
+  if (!isSDCardInserted()) {
+    master.print(1, 0, "NO SD - WON'T SAVE!");
     master.rumble("---");
   }
 
-  // CRITICAL: Reset odometry to (0, 0, 0) for consistent reference
-  chassis.setPose(0, 0, 0);
+  if (countdownDuration == 0) {
+    beginRecording(pros::micros());
+    return;
+  }
+
+  // Countdown runs from update(); recording starts exactly at countdownEnd
+  countdownEnd = pros::micros() + static_cast<uint64_t>(countdownDuration) * 1000;
+  countdownShown = 0;
+  recordState = RecordState::Countdown;
+}
 
-  recordStartTime = pros::micros();
+void PositionReplay::beginRecording(uint64_t startTime) {
+  embeddedFile = {nullptr, 0};
+  // Returns the chunks to the pool; frames are appended into preallocated
+  // chunks from here on, so the driver loop never allocates
+  recording.clear();
+
+  // CRITICAL: Reset odometry to the field start pose for consistent reference
+  resetPose(recordStartPose);
+  recordingStartPose = recordStartPose;
+  startPose = recordStartPose;
+  startWallDistance = readWallDistance();
+
+  // Timestamps count from the scheduled start, not from whichever loop
+  // iteration noticed it
+  recordStartTime = startTime;
   lastRecordTime = 0;
-  _isRecording = true;
+  recordState = RecordState::Recording;
   prevButtons = 0;
 
   // Removed task priority manipulation to avoid starvation risks
@@ -125,33 +187,106 @@ void PositionReplay::startRecording() {
   master.print(0, 0, "RECORDING (POS)... ");
   master.rumble("-");
 
+  // Clear the countdown off the menu
+  drawReplayMenu();
   drawStatusIndicator();
 }
 
 void PositionReplay::stopRecording(bool saveToSD) {
-  _isRecording = false;
+  // Stopping during the countdown just cancels it
+  if (recordState == RecordState::Countdown) {
+    recordState = RecordState::Idle;
+    master.print(0, 0, "REC CANCELLED      ");
+    return;
+  }
+  if (recordState != RecordState::Recording)
+    return;
 
   // Removed task priority restoration
 
   master.print(0, 0, "STOPPED: %d pts   ", recording.size());
   master.rumble(".");
 
-  if (saveToSD) {
-    if (!isSDCardInserted()) {
-      master.print(1, 0, "NO SD CARD!        ");
+  // Playback runs from the resampled copy; the raw frames are only kept for
+  // the save
+  buildPlan();
+  reportPlan();
+
+  if (!saveToSD) {
+    recordState = RecordState::Idle;
+  } else if (!isSDCardInserted()) {
+    recordState = RecordState::Idle;
+    master.print(1, 0, "NO SD CARD!        ");
+    master.rumble("---");
+  } else {
+    // Hand the frames to the SD writer task (moved, not copied) so driving
+    // never stalls on the card. They come back in onComplete, which runs on
+    // the writer task; nothing touches `recording` until the state is Idle.
+    RecordingSaveJob job;
+    job.path = filePath;
+    job.frames = std::move(recording);
+    job.start = {recordingStartPose.x, recordingStartPose.y,
+                 recordingStartPose.theta, startWallDistance};
+    job.onComplete = [this](RecordingSaveJob &done) {
+      recording = std::move(done.frames);
+      if (done.ok) {
+        recordingChecksum = done.checksum;
+        updateCatalogEntry();
+      }
+      lastSaveTimeMs = done.writeTimeMs;
+      saveReport = done.ok ? 1 : 2;
+      recordState = RecordState::Idle;
+    };
+
+    recordState = RecordState::Saving;
+    if (!sdWriter.submit(std::move(job))) {
+      recording = std::move(job.frames);
+      recordState = RecordState::Idle;
+      master.print(1, 0, "SAVE QUEUE FULL!   ");
       master.rumble("---");
-    } else if (this->saveToSD()) {
-      master.print(1, 0, "SAVED TO SD!       ");
-    } else {
-      master.print(1, 0, "SD SAVE FAILED!    ");
     }
   }
 
   drawStatusIndicator();
 }
 
+void PositionReplay::update() {
+  switch (recordState) {
+  case RecordState::Countdown: {
+    uint64_t now = pros::micros();
+    if (now >= countdownEnd) {
+      beginRecording(countdownEnd);
+      break;
+    }
+    int seconds = static_cast<int>((countdownEnd - now + 999999) / 1000000);
+    if (seconds != countdownShown) {
+      countdownShown = seconds;
+      displayCountdown(seconds);
+    }
+    break;
+  }
+  case RecordState::Recording:
+    recordFrame();
+    break;
+  default:
+    break;
+  }
+
+  // Report a finished background save
+  switch (saveReport.exchange(0)) {
+  case 1:
+    master.print(1, 0, "SAVED TO SD! %lums  ",
+                 static_cast<unsigned long>(lastSaveTimeMs));
+    break;
+  case 2:
+    master.print(1, 0, "SD SAVE FAILED!    ");
+    master.rumble("---");
+    break;
+  }
+}
+
 void PositionReplay::recordFrame() {
-  if (!_isRecording)
+  if (recordState != RecordState::Recording)
     return;
 
   uint64_t currentTime = pros::micros() - recordStartTime;
@@ -165,32 +300,21 @@ void PositionReplay::recordFrame() {
 
   lastRecordTime = currentTime;
 
-  // Get current pose from LemLib odometry
-  lemlib::Pose pose = chassis.getPose();
+  // Get current pose from odometry
+  lemlib::Pose pose = readPose();
 
   // Get current button state
   uint8_t currentButtons = packButtons();
 
-  // Determine if any action is happening at this frame
-  bool actionOccurred = false;
-
-  // Check for button state changes (pneumatic toggles)
-  if (wasPressed(currentButtons, prevButtons, BTN_X) ||
-      wasPressed(currentButtons, prevButtons, BTN_A) ||
-      wasPressed(currentButtons, prevButtons, BTN_B)) {
-    actionOccurred = true;
-  }
-
-  // Check if motor power is significant (intake/outtake active)
   int intakeVoltage = Intake.get_voltage();
   int outtakeVoltage = Outtake.get_voltage();
   int8_t intakePower = static_cast<int8_t>(intakeVoltage * 127 / 12000);
   int8_t outtakePower = static_cast<int8_t>(outtakeVoltage * 127 / 12000);
 
-  // Consider motor action if power is above threshold
-  if (std::abs(intakePower) > 10 || std::abs(outtakePower) > 10) {
-    actionOccurred = true;
-  }
+  // A toggle pressed or a mechanism running (derived again when the
+  // capture buffer is read back)
+  bool actionOccurred =
+      isActionFrame(currentButtons, prevButtons, intakePower, outtakePower);
 
   // Build frame
   WaypointFrame frame;
@@ -205,13 +329,12 @@ void PositionReplay::recordFrame() {
 
   prevButtons = currentButtons;
 
-  // Safe push_back with hard limit
-  if (recording.size() >= MAX_FRAMES) {
+  // Hard limit (and the pool's capacity)
+  if (recording.size() >= MAX_FRAMES || !recording.push_back(frame)) {
     master.print(0, 0, "MAX FRAMES REACHED!");
     stopRecording(true);
     return;
   }
-  recording.push_back(frame);
 
   // Blink indicator
   uint32_t elapsedSec = currentTimeMs / 500;
@@ -251,23 +374,114 @@ void PositionReplay::executeActions(const WaypointFrame &frame,
   lastPlaybackButtons = frame.buttons;
 }
 
-void PositionReplay::playback() {
+void PositionReplay::applyToggles(uint8_t toggles, bool &midScoring,
+                                  bool &descore, bool &unloader) {
+  if (toggles & (1 << BTN_X)) {
+    midScoring = !midScoring;
+    MidScoring.set_value(midScoring);
+  }
+  if (toggles & (1 << BTN_A)) {
+    descore = !descore;
+    Descore.set_value(descore);
+  }
+  if (toggles & (1 << BTN_B)) {
+    unloader = !unloader;
+    Unloader.set_value(unloader);
+  }
+}
+
+bool PositionReplay::claimPlayback() {
   // Prevent starting playback while recording
-  if (_isRecording) {
+  if (isRecording()) {
     master.print(0, 0, "STOP REC FIRST!    ");
     master.rumble("---");
-    return;
+    return false;
   }
 
-  if (recording.empty()) {
+  // One run at a time
+  bool expected = false;
+  if (!_isPlaying.compare_exchange_strong(expected, true)) {
+    return false;
+  }
+  _abortRequested = false;
+  abortLatencyUs = 0;
+  playbackFrame = 0;
+  playbackProgress = 0;
+  trackingError = 0;
+  playbackResult = PlaybackResult::Running;
+  playbackRun++;
+  return true;
+}
+
+void PositionReplay::playback() {
+  if (claimPlayback()) {
+    runPlayback();
+  }
+}
+
+PlaybackHandle PositionReplay::playbackAsync() {
+  if (!claimPlayback()) {
+    return PlaybackHandle();
+  }
+  PlaybackHandle handle(this, playbackRun);
+
+  // Above opcontrol so screen redraws and touch debouncing in the driver
+  // loop can't delay a control step
+  pros::Task task([this]() { runPlayback(); }, TASK_PRIORITY_DEFAULT + 1,
+                  TASK_STACK_DEPTH_DEFAULT, "replay playback");
+  return handle;
+}
+
+void PositionReplay::runPlayback() {
+  {
+    std::lock_guard<pros::Mutex> lock(playbackTaskMutex);
+    playbackTask = pros::c::task_get_current();
+  }
+  // Drop a wake-up left over from an earlier run
+  pros::Task::notify_take(true, 0);
+
+  PlaybackResult result = PlaybackResult::Failed;
+
+  // The frames are with the SD writer until the save finishes
+  if (isSaving()) {
+    master.print(0, 0, "WAITING FOR SAVE...");
+    uint32_t waitStart = pros::millis();
+    while (isSaving() && !_abortRequested &&
+           pros::millis() - waitStart < loadWaitTimeout) {
+      pros::delay(5);
+    }
+    if (isSaving()) {
+      master.print(0, 0, "SAVE NOT DONE!     ");
+      master.rumble("---");
+      finishPlayback(result);
+      return;
+    }
+  }
+
+  // A background load may still be running (e.g. started in initialize())
+  if (isLoading()) {
+    master.print(0, 0, "WAITING FOR LOAD...");
+    waitForLoad(loadWaitTimeout);
+    if (isLoading()) {
+      master.print(0, 0, "LOAD NOT READY!    ");
+      master.rumble("---");
+      finishPlayback(result);
+      return;
+    }
+  }
+
+  if (plan.empty()) {
     if (!loadFromSD()) {
       master.print(0, 0, "NO RECORDING!      ");
+      finishPlayback(result);
       return;
     }
   }
 
-  _isPlaying = true;
-  _abortRequested = false;
+  if (_abortRequested) {
+    finishPlayback(PlaybackResult::Cancelled);
+    return;
+  }
 
   // Initial pneumatic states match initializeRobot() defaults
   bool midScoring = false; // Retracted by default (matches initializeRobot)
@@ -279,8 +493,9 @@ void PositionReplay::playback() {
   Descore.set_value(descore);
   Unloader.set_value(unloader);
 
-  // Reset pose to starting position
-  chassis.setPose(0, 0, 0);
+  // Reset pose to where the robot actually is: the recording's (possibly
+  // transformed) start, corrected once by the alignment sensors
+  resetPose(estimateStartPose());
   pros::delay(50);
 
   master.print(0, 0, "REPLAYING (<>=STOP)");
@@ -290,130 +505,174 @@ void PositionReplay::playback() {
   pros::screen::fill_circle(460, 20, 15);
 
   // Reset state for playback
-  lastPlaybackButtons = 0;
-  prevDistanceError = 0;
-  prevHeadingError = 0;
+  size_t nextToggleFrame = 0; // First plan frame whose toggles aren't applied
+  TrackingMode tracking = trackingMode; // Fixed for the run
+  controller.reset();
+  ramsete.reset();
+  mpc.reset();
+  worstUpdateUs = 0;
+
+  // Position-triggered actions: index this plan's events (it may have been
+  // transformed since it was built) and start with the mechanisms stopped
+  bool positionTriggered = actionTriggerMode == ActionTriggerMode::Position;
+  size_t firedEvents = 0;
+  size_t windowFrames = static_cast<uint64_t>(actionWindowMs) * 1000 / planPeriodUs;
+  int8_t intakePower = 0;
+  int8_t outtakePower = 0;
+  if (positionTriggered) {
+    actionTriggers.build(plan, actionTriggerRadius);
+  }
+
+  // Re-sync after a push: the clock is shifted to the frame the robot is
+  // nearest to instead of the robot chasing a setpoint it has lost
+  bool resyncEnabled = resyncDistance > 0;
+  int64_t timeOffset = 0; // Added to the clock by re-syncs
+  uint64_t nextResync = 0;
+  resyncCount = 0;
+  if (resyncEnabled) {
+    pathIndex.build(plan);
+  }
+
+  // Buffer is reserved here so logging never allocates inside the loop
+  runLog.begin(recordingChecksum);
 
   uint64_t startTime = pros::micros();
-  // Use last frame's timestamp as total duration
-  uint64_t totalDuration = recording.back().timestamp;
+  uint64_t lastTickTime = 0;
+  // The plan's last point is at or just after the last recorded frame
+  uint64_t totalDuration = static_cast<uint64_t>(plan.size() - 1) * planPeriodUs;
 
   // ===== TIME-SYNCED PURSUIT LOOP =====
-  while (!_abortRequested && !checkEmergencyStop()) {
-    uint64_t elapsed = pros::micros() - startTime;
+  result = PlaybackResult::Completed;
+  while (true) {
+    if (!_abortRequested && checkEmergencyStop()) {
+      abortRequestTime = static_cast<uint32_t>(pros::micros());
+      _abortRequested = true;
+    }
+    if (_abortRequested) {
+      result = PlaybackResult::Cancelled;
+      break;
+    }
+
+    uint64_t wallElapsed = pros::micros() - startTime;
+    uint64_t elapsed = static_cast<uint64_t>(
+        std::max<int64_t>(static_cast<int64_t>(wallElapsed) + timeOffset, 0));
     if (elapsed >= totalDuration)
       break;
 
     // Find target frame based on elapsed time
     size_t idx = findFrameIndexAtTime(elapsed);
-    const WaypointFrame &target = recording[idx];
-
-    // --- CUSTOM LIGHTWEIGHT PURE PURSUIT ---
-    // We act like a pursuit controller following the moving target point
-
-    lemlib::Pose current = chassis.getPose();
-    float dx = target.x - current.x;
-    float dy = target.y - current.y;
-    float distance = std::sqrt(dx * dx + dy * dy);
-
-    // Calculate desired heading toward target
-    // atan2 returns radians, convert to degrees
-    float targetHeading = std::atan2(dy, dx) * 180.0f / M_PI;
-
-    // Heading error wrapping
-    float headingError = targetHeading - current.theta;
-    while (headingError > 180)
-      headingError -= 360;
-    while (headingError < -180)
-      headingError += 360;
-
-    // PD controller using tuned LemLib values from robot_config.cpp
-    // Lateral (forward): kP=5, kD=8
-    // Angular (turn): kP=1.7, kD=14
-    float kP_forward = 5.0f;
-    float kD_forward = 8.0f;
-    float kP_turn = 1.7f;
-    float kD_turn = 14.0f;
-
-    // Calculate derivative terms
-    float distanceDerivative = distance - prevDistanceError;
-    float headingDerivative = headingError - prevHeadingError;
-
-    float forward = distance * kP_forward + distanceDerivative * kD_forward;
-    float turn = headingError * kP_turn + headingDerivative * kD_turn;
-
-    // Update previous errors for next iteration
-    prevDistanceError = distance;
-    prevHeadingError = headingError;
-
-    // Determine if robot should be driving backward:
-    // Dot product of robot's heading vector with target direction vector
-    // If negative, the target is behind the robot, so drive in reverse.
-    float headingRad = current.theta * M_PI / 180.0f;
-    float forwardDotProduct =
-        dx * std::cos(headingRad) + dy * std::sin(headingRad);
-    if (forwardDotProduct < 0) {
-      forward = -forward;
+    GridFrame target = plan[idx];
+    playbackFrame = idx;
+    playbackProgress = static_cast<float>(elapsed) / totalDuration;
+
+    // Measure the real loop period (pose read to next pose read)
+    uint64_t tickTime = pros::micros();
+    if (lastTickTime != 0) {
+      measuredLoopPeriod = lemlib::ema((tickTime - lastTickTime) / 1000.0f,
+                                       measuredLoopPeriod, 0.1f);
+    }
+    lastTickTime = tickTime;
+
+    // Latency compensation: the command computed now is applied until the
+    // next tick, so act on where the robot will be rather than the (already
+    // stale) odometry pose
+    float horizonMs =
+        predictionHorizon < 0 ? measuredLoopPeriod : predictionHorizon;
+    lastHorizonUsed = horizonMs;
+    lemlib::Pose current = readPose(horizonMs);
+
+    // Where the robot actually is (not the prediction)
+    lemlib::Pose achieved = horizonMs > 0 ? readPose() : current;
+
+    // Knocked well off the path (not just behind on it): rejoin it at the
+    // nearest frame within a window around the clock (mostly behind it - a
+    // pushed robot has lost ground), if that is much closer than the target
+    uint8_t flags = 0;
+    float deviation = std::hypot(target.x - achieved.x, target.y - achieved.y);
+    if (resyncEnabled && deviation > resyncDistance &&
+        wallElapsed >= nextResync) {
+      size_t back = RESYNC_BACK_MS * 1000 / planPeriodUs;
+      size_t ahead = RESYNC_AHEAD_MS * 1000 / planPeriodUs;
+      size_t nearest;
+      if (pathIndex.rejoin(achieved.x, achieved.y, idx > back ? idx - back : 0,
+                           std::min(idx + ahead, plan.size() - 1),
+                           resyncDistance, deviation, nearest)) {
+        timeOffset += static_cast<int64_t>(nearest) * planPeriodUs -
+                      static_cast<int64_t>(elapsed);
+        idx = nearest;
+        target = plan[idx];
+        playbackFrame = idx;
+        controller.reset(); // No derivative kick from the jump
+        ramsete.reset();
+        mpc.restart();
+        resyncCount++;
+        flags |= RUN_FLAG_RESYNC;
+      }
+      nextResync = wallElapsed + RESYNC_COOLDOWN_MS * 1000;
     }
 
-    // Clamp output
-    if (forward > 127)
-      forward = 127;
-    if (forward < -127)
-      forward = -127;
-    if (turn > 127)
-      turn = 127;
-    if (turn < -127)
-      turn = -127;
-
-    // Special case: If we are extremely close to the point (within 0.5 inch),
-    // match the recorded heading instead of driving to the point
-    if (distance < 0.5f) {
-      forward = 0;
-      float thetaError = target.theta - current.theta;
-      while (thetaError > 180)
-        thetaError -= 360;
-      while (thetaError < -180)
-        thetaError += 360;
-
-      // Use same PD values for heading correction
-      float thetaDerivative = thetaError - prevHeadingError;
-      turn = thetaError * kP_turn + thetaDerivative * kD_turn;
-      prevHeadingError = thetaError;
-
-      if (turn > 127)
-        turn = 127;
-      if (turn < -127)
-        turn = -127;
+    uint8_t toggles = 0;
+    bool action = false;
+    if (positionTriggered) {
+      // Events fire where they were recorded, or late by the window
+      size_t fired = actionTriggers.update(achieved.x, achieved.y, idx,
+                                           windowFrames);
+      for (; firedEvents < fired; firedEvents++) {
+        const PlanEvent &event = actionTriggers[firedEvents];
+        toggles ^= event.toggles;
+        intakePower = event.intakePower;
+        outtakePower = event.outtakePower;
+        action = true;
+      }
+    } else {
+      // A tick can pass several plan frames; every press among them still
+      // toggles its piston (in order, so the parity is right)
+      for (; nextToggleFrame <= idx; nextToggleFrame++) {
+        toggles ^= plan[nextToggleFrame].toggles;
+        action = action || plan[nextToggleFrame].hasAction;
+      }
+      intakePower = target.intakePower;
+      outtakePower = target.outtakePower;
+    }
+
+    if (action)
+      flags |= RUN_FLAG_ACTION;
+    runLog.add({static_cast<uint32_t>(wallElapsed / 1000),
+                static_cast<uint32_t>(idx * planPeriodUs / 1000),
+                static_cast<uint16_t>(idx), flags, 0,
+                achieved.x, achieved.y, achieved.theta, target.x, target.y});
+    trackingError = std::hypot(target.x - achieved.x, target.y - achieved.y);
+
+    // Chase the moving target; Ramsete also feeds forward the plan's
+    // velocity, MPC plans over the frames ahead (fixed work per tick)
+    uint64_t updateStart = pros::micros();
+    DriveCommand command;
+    if (tracking == TrackingMode::Mpc) {
+      command = mpc.update(plan, idx, current.x, current.y, current.theta,
+                           measuredLoopPeriod);
+    } else {
+      TrackingTarget reference = {target.x, target.y, target.theta,
+                                  plan.speed(idx), plan.turnRate(idx)};
+      command =
+          tracking == TrackingMode::Ramsete
+              ? ramsete.update(reference, current.x, current.y, current.theta)
+              : controller.update(reference, current.x, current.y,
+                                  current.theta);
     }
+    worstUpdateUs = std::max(
+        worstUpdateUs, static_cast<uint32_t>(pros::micros() - updateStart));
 
     // Apply drive power (Arcade: left = fwd + turn, right = fwd - turn)
-    left_motors.move(forward + turn);
-    right_motors.move(forward - turn);
+    left_motors.move(command.forward + command.turn);
+    right_motors.move(command.forward - command.turn);
 
     // --- APPLY MECHANISM STATES ---
-    // Direct application from recorded frame
-    Intake.move(target.intakePower);
-    Outtake.move(target.outtakePower);
+    // From the target frame, or the latest event that fired
+    Intake.move(intakePower);
+    Outtake.move(outtakePower);
 
-    // Pneumatic toggles with edge detection
-    // Note: We use the helper logic inline here or call executeActions if
-    // preferred. Inline is clearer for this loop structure.
-
-    if (wasPressed(target.buttons, lastPlaybackButtons, BTN_X)) {
-      midScoring = !midScoring;
-      MidScoring.set_value(midScoring);
-    }
-    if (wasPressed(target.buttons, lastPlaybackButtons, BTN_A)) {
-      descore = !descore;
-      Descore.set_value(descore);
-    }
-    if (wasPressed(target.buttons, lastPlaybackButtons, BTN_B)) {
-      unloader = !unloader;
-      Unloader.set_value(unloader);
-    }
-
-    lastPlaybackButtons = target.buttons;
+    // Pneumatic toggles (presses were found when the plan was built)
+    applyToggles(toggles, midScoring, descore, unloader);
 
     // Blink indicator
     uint32_t currentMs = pros::millis();
@@ -424,7 +683,23 @@ void PositionReplay::playback() {
     }
     pros::screen::fill_circle(460, 20, 15);
 
-    pros::delay(20);
+    // Sleep until the next step, or until abortPlayback() wakes us
+    pros::Task::notify_take(true, 20);
+  }
+
+  // A completed run still owes the presses after the last tick: position
+  // events in the final window never reach their fallback, and the clock
+  // stops short of the last plan frames
+  if (result == PlaybackResult::Completed) {
+    uint8_t toggles = 0;
+    if (positionTriggered) {
+      for (; firedEvents < actionTriggers.size(); firedEvents++)
+        toggles ^= actionTriggers[firedEvents].toggles;
+    } else {
+      for (; nextToggleFrame < plan.size(); nextToggleFrame++)
+        toggles ^= plan[nextToggleFrame].toggles;
+    }
+    applyToggles(toggles, midScoring, descore, unloader);
   }
 
   // Stop all motors
@@ -432,32 +707,161 @@ void PositionReplay::playback() {
   right_motors.move(0);
   Intake.move(0);
   Outtake.move(0);
+  if (result == PlaybackResult::Cancelled) {
+    abortLatencyUs = static_cast<uint32_t>(pros::micros()) - abortRequestTime;
+  }
 
-  _isPlaying = false;
-  _abortRequested = false;
+  // Score the run against the last recorded frame and keep it on the card
+  GridFrame last = plan.back();
+  lemlib::Pose finalPose = readPose();
+  runLog.add({static_cast<uint32_t>((pros::micros() - startTime) / 1000),
+              static_cast<uint32_t>(totalDuration / 1000),
+              static_cast<uint16_t>(plan.size() - 1), 0, 0, finalPose.x,
+              finalPose.y, finalPose.theta, last.x, last.y});
+  const RunSummary &summary = runLog.finish(last.x, last.y, last.theta);
+  if (isSDCardInserted()) {
+    runLog.save(RunLog::pathFor(filePath));
+  }
 
   if (pros::competition::is_disabled()) {
     master.print(0, 0, "GAME DISABLED!     ");
+  } else if (result == PlaybackResult::Cancelled) {
+    master.print(0, 0, "STOPPED in %.2fms  ", abortLatencyUs / 1000.0f);
+  } else if (resyncCount > 0) {
+    master.print(0, 0, "COMPLETE (%lu RESYNC)",
+                 static_cast<unsigned long>(resyncCount));
   } else {
     master.print(0, 0, "REPLAY COMPLETE!   ");
   }
+  master.print(1, 0, "dt %.1fms pred %.0fms ", measuredLoopPeriod,
+               lastHorizonUsed);
+  master.print(2, 0, "err %.1f/%.1f %+.0fms ", summary.rmsCrossTrack,
+               summary.finalPositionError, summary.meanTimeBehind);
 
   // Clear indicator
   pros::screen::set_pen(pros::c::COLOR_BLACK);
   pros::screen::fill_circle(460, 20, 15);
+
+  if (result == PlaybackResult::Completed) {
+    playbackProgress = 1.0f;
+  }
+  finishPlayback(result);
+}
+
+void PositionReplay::finishPlayback(PlaybackResult result) {
+  {
+    std::lock_guard<pros::Mutex> lock(playbackTaskMutex);
+    playbackTask = nullptr;
+  }
+  // Result first: a handle only reports finished once _isPlaying drops
+  playbackResult = result;
+  _abortRequested = false;
+  _isPlaying = false;
+}
+
+// ==================== Playback Handle ====================
+
+bool PlaybackHandle::isRunning() const {
+  return replay && replay->playbackRun == run && replay->_isPlaying;
+}
+
+PlaybackResult PlaybackHandle::result() const {
+  if (!replay || replay->playbackRun != run)
+    return PlaybackResult::None;
+  return replay->playbackResult;
+}
+
+float PlaybackHandle::progress() const {
+  return replay && replay->playbackRun == run ? replay->playbackProgress.load()
+                                              : 0.0f;
+}
+
+uint32_t PlaybackHandle::currentFrame() const {
+  return replay && replay->playbackRun == run ? replay->playbackFrame.load() : 0;
+}
+
+float PlaybackHandle::trackingError() const {
+  return replay && replay->playbackRun == run ? replay->trackingError.load()
+                                              : 0.0f;
+}
+
+uint32_t PlaybackHandle::abortLatencyUs() const {
+  return replay && replay->playbackRun == run ? replay->abortLatencyUs.load()
+                                              : 0;
+}
+
+void PlaybackHandle::cancel() {
+  if (isRunning()) {
+    replay->abortPlayback();
+  }
+}
+
+bool PlaybackHandle::wait(uint32_t timeoutMs) {
+  uint32_t start = pros::millis();
+  while (isRunning()) {
+    if (timeoutMs != TIMEOUT_MAX && pros::millis() - start >= timeoutMs)
+      return false;
+    pros::delay(5);
+  }
+  return true;
 }
 
 // ==================== Data Management ====================
 
 void PositionReplay::clearRecording() {
+  if (isLoading() || recordState != RecordState::Idle || _isPlaying)
+    return;
+  embeddedFile = {nullptr, 0};
   recording.clear();
+  plan.clear();
+  sourceFrameCount = 0;
+  recordingChecksum = 0;
   master.print(0, 0, "RECORDING CLEARED  ");
 }
 
 uint32_t PositionReplay::getDuration() const {
-  if (recording.empty())
+  if (plan.empty())
     return 0;
-  return recording.back().timestamp / 1000; // Convert micros to ms
+  return (plan.size() - 1) * planPeriodUs / 1000; // Convert micros to ms
+}
+
+// ==================== Resampling ====================
+
+void PositionReplay::buildPlan() {
+  planPeriodUs = gridPeriod * 1000;
+  std::vector<GridFrame> frames;
+  GridResampler resampler;
+  resampler.begin(frames, planPeriodUs, recordingInterval * 1000);
+  if (!recording.empty()) {
+    frames.reserve(recording.duration() / planPeriodUs + 2);
+  }
+  for (const WaypointFrame &frame : recording) {
+    resampler.add(frame);
+  }
+  lastResample = resampler.finish();
+  storePlan(frames);
+  sourceFrameCount = recording.size();
+}
+
+void PositionReplay::storePlan(std::vector<GridFrame> &frames) {
+  lastTrim = trimIdleEnabled ? trimIdle(frames, planPeriodUs, idleTrim)
+                             : IdleTrimReport();
+  // Full-precision frames only live until they're quantized
+  plan.encode(frames, planPeriodUs);
+  planFromCache = false;
+}
+
+void PositionReplay::reportPlan() {
+  if (lastResample.droppedSamples > 0 || lastResample.outOfOrder > 0) {
+    master.print(1, 0, "DROPPED %lu gap %lums ",
+                 static_cast<unsigned long>(lastResample.droppedSamples +
+                                            lastResample.outOfOrder),
+                 static_cast<unsigned long>(lastResample.longestGapMs));
+  }
+  if (lastTrim.intervals > 0) {
+    master.print(2, 0, "TRIMMED %.1fs (%lu)  ", lastTrim.secondsSaved,
+                 static_cast<unsigned long>(lastTrim.intervals));
+  }
 }
 
 bool PositionReplay::saveToSD() {
@@ -465,80 +869,427 @@ bool PositionReplay::saveToSD() {
     return false;
   }
 
-  FILE *file = fopen(filePath.c_str(), "wb");
-  if (!file) {
+  RecordingStartInfo start = {recordingStartPose.x, recordingStartPose.y,
+                              recordingStartPose.theta, startWallDistance};
+  uint32_t crc;
+  if (recording.empty() ||
+      !writeRecordingFile(filePath, start, recording, crc)) {
     return false;
   }
 
-  // Write header: magic number + version + frame count
-  uint32_t magic = 0x504F5352; // "POSR" for Position Recording
-  uint32_t version = 1;
-  uint32_t frameCount = recording.size();
+  // Update the slot catalog so the menu can list this recording
+  recordingChecksum = crc;
+  updateCatalogEntry();
+  return true;
+}
 
-  fwrite(&magic, sizeof(uint32_t), 1, file);
-  fwrite(&version, sizeof(uint32_t), 1, file);
-  fwrite(&frameCount, sizeof(uint32_t), 1, file);
+bool PositionReplay::loadFromSD() {
+  // Don't fight a background load over the recording buffer
+  if (isLoading()) {
+    return waitForLoad(loadWaitTimeout);
+  }
+  if (recordState != RecordState::Idle) {
+    return false;
+  }
+
+  loadedFrames = 0;
+  loadTotalFrames = 0;
+  loadState = LoadState::Loading;
+  bool loaded = readFromSD() || readFallback();
+  loadState = loaded ? LoadState::Ready : LoadState::Failed;
+  return loaded;
+}
 
-  // Write all frames
-  for (const auto &frame : recording) {
-    fwrite(&frame, sizeof(WaypointFrame), 1, file);
+void PositionReplay::loadFromSDAsync() {
+  // Never load over a recording that is being captured or saved
+  if (recordState != RecordState::Idle) {
+    return;
   }
 
-  fclose(file);
-  return true;
+  // Only one load at a time
+  LoadState expected = loadState;
+  if (expected == LoadState::Loading ||
+      !loadState.compare_exchange_strong(expected, LoadState::Loading)) {
+    return;
+  }
+  loadedFrames = 0;
+  loadTotalFrames = 0;
+
+  pros::Task loadTask(
+      [this]() {
+        bool loaded = readFromSD() || readFallback();
+        loadState = loaded ? LoadState::Ready : LoadState::Failed;
+
+        // The menu shows the loaded recording's info once the UI redraws
+        menuRedraw = true;
+      },
+      "replay load");
 }
 
-bool PositionReplay::loadFromSD() {
+bool PositionReplay::waitForLoad(uint32_t timeoutMs) {
+  uint32_t start = pros::millis();
+  while (isLoading() && pros::millis() - start < timeoutMs) {
+    pros::delay(5);
+  }
+  return loadState == LoadState::Ready;
+}
+
+bool PositionReplay::readFromSD() {
   if (!isSDCardInserted()) {
     master.print(0, 0, "NO SD CARD!        ");
     return false;
   }
 
-  FILE *file = fopen(filePath.c_str(), "rb");
+  if (!readRecordingFile(filePath)) {
+    // A save interrupted after the old file was removed leaves only the
+    // (complete, CRC-checked) temp file - recover it
+    std::string tempPath = filePath + ".tmp";
+    if (!readRecordingFile(tempPath)) {
+      return false;
+    }
+    replaceFile(tempPath, filePath);
+  }
+
+  // Recordings made before the catalog existed - add them to it
+  const CatalogEntry &entry =
+      recordingLibrary.getEntry(recordingLibrary.getActiveSlot());
+  if (!entry.used || entry.frameCount != sourceFrameCount ||
+      entry.checksum != recordingChecksum) {
+    updateCatalogEntry();
+  }
+
+  // Mirror/rotate/translate once here so playback never transforms per tick
+  startPose = recordingStartPose;
+  applyTransform(loadTransform);
+
+  master.print(0, 0, "LOADED: %d pts%s    ", sourceFrameCount,
+               planFromCache ? " C" : "");
+  reportPlan();
+  return true;
+}
+
+bool PositionReplay::readRecordingFile(const std::string &path) {
+  FILE *file = fopen(path.c_str(), "rb");
   if (!file) {
     return false;
   }
 
-  // Read header
-  uint32_t magic, version, frameCount;
-  if (fread(&magic, sizeof(uint32_t), 1, file) != 1 ||
-      fread(&version, sizeof(uint32_t), 1, file) != 1 ||
-      fread(&frameCount, sizeof(uint32_t), 1, file) != 1) {
+  // Read header: magic number + version + frame count
+  uint32_t header[3];
+  if (fread(header, sizeof(header), 1, file) != 1) {
     fclose(file);
     return false;
   }
+  uint32_t magic = header[0];
+  uint32_t version = header[1];
+  uint32_t frameCount = header[2];
 
   // Verify magic number
-  if (magic != 0x504F5352) {
+  if (magic != RECORDING_MAGIC || version > RECORDING_VERSION) {
     fclose(file);
     master.print(0, 0, "INVALID FILE!      ");
     return false;
   }
 
-  // Sanity check (max ~2000 frames = ~3.3 mins at 10 samples/sec)
-  if (frameCount > 5000) {
+  // Sanity check against the recording limit
+  if (frameCount > MAX_FRAMES) {
     fclose(file);
     master.print(0, 0, "FILE TOO LARGE!    ");
     return false;
   }
 
-  // Read all frames
-  recording.clear();
-  recording.resize(frameCount);
+  uint32_t crc = crc32(header, sizeof(header));
+
+  // Older files were always recorded from (0, 0, 0) without a wall reading
+  RecordingStartInfo start = {0, 0, 0, -1};
+  if (version >= 3) {
+    if (fread(&start, sizeof(start), 1, file) != 1) {
+      fclose(file);
+      return false;
+    }
+    crc = crc32(&start, sizeof(start), crc);
+  }
 
-  for (uint32_t i = 0; i < frameCount; i++) {
-    if (fread(&recording[i], sizeof(WaypointFrame), 1, file) != 1) {
+  // A plan built from this exact recording may already be on the card. The
+  // key is the CRC in the file's trailer, so only the header and trailer are
+  // read before deciding (version 1 files have no trailer and aren't cached).
+  PlanCacheKey cacheKey = planCacheKey(0, frameCount);
+  long dataStart = ftell(file);
+  if (version >= 2 &&
+      fseek(file, -static_cast<long>(sizeof(uint32_t)), SEEK_END) == 0 &&
+      fread(&cacheKey.recordingChecksum, sizeof(uint32_t), 1, file) == 1) {
+    CachedPlan cached;
+    if (readPlanCache(planCachePath(filePath), cacheKey, MAX_CACHED_PLAN_FRAMES,
+                      cached)) {
       fclose(file);
+      planPeriodUs = cached.plan.getPeriod();
+      plan = std::move(cached.plan);
+      lastResample = cached.resample;
+      lastTrim = cached.trim;
+      sourceFrameCount = frameCount;
+      loadTotalFrames = frameCount;
+      loadedFrames = frameCount;
+      planFromCache = true;
+
+      embeddedFile = {nullptr, 0};
       recording.clear();
+      recordingChecksum = cacheKey.recordingChecksum;
+      recordingStartPose = lemlib::Pose(start.x, start.y, start.theta);
+      startWallDistance = start.wallDistance;
+      return true;
+    }
+  }
+  if (fseek(file, dataStart, SEEK_SET) != 0) {
+    fclose(file);
+    return false;
+  }
+
+  // Resample while reading: chunks go straight through the resampler, so
+  // the raw frames (and their timestamps) are never held in memory. The old
+  // plan stays in place until the whole file has checked out.
+  std::vector<GridFrame> loaded;
+  loaded.reserve(frameCount * recordingInterval / gridPeriod + 2);
+  GridResampler resampler;
+  resampler.begin(loaded, gridPeriod * 1000, recordingInterval * 1000);
+  loadTotalFrames = frameCount;
+
+  // Read in chunks so progress can be reported while the card is busy; the
+  // CRC is folded in while each chunk is still hot in cache
+  constexpr uint32_t CHUNK_FRAMES = 128;
+  WaypointFrame chunk[CHUNK_FRAMES];
+  for (uint32_t i = 0; i < frameCount; i += CHUNK_FRAMES) {
+    uint32_t count = std::min(CHUNK_FRAMES, frameCount - i);
+    if (fread(chunk, sizeof(WaypointFrame), count, file) != count) {
+      fclose(file);
       return false;
     }
+    crc = crc32(chunk, count * sizeof(WaypointFrame), crc);
+    for (uint32_t j = 0; j < count; j++) {
+      resampler.add(chunk[j]);
+    }
+    loadedFrames = i + count;
   }
 
+  // Version 1 files have no trailer - nothing to verify against
+  if (version >= 2) {
+    uint32_t storedCrc;
+    if (fread(&storedCrc, sizeof(uint32_t), 1, file) != 1 ||
+        storedCrc != crc) {
+      fclose(file);
+      master.print(0, 0, "CRC MISMATCH!      ");
+      master.rumble("---");
+      return false;
+    }
+  }
+
+  lastResample = resampler.finish();
+  planPeriodUs = gridPeriod * 1000;
+  storePlan(loaded);
+  sourceFrameCount = frameCount;
+
+  // The capture buffer no longer matches what's loaded; saveToSD() must not
+  // write it over this slot
+  embeddedFile = {nullptr, 0};
+  recording.clear();
+
   fclose(file);
-  master.print(0, 0, "LOADED: %d pts     ", frameCount);
+  recordingChecksum = crc;
+  recordingStartPose = lemlib::Pose(start.x, start.y, start.theta);
+  startWallDistance = start.wallDistance;
+
+  // Next time this recording loads it skips all of the above (a failed
+  // write just means another rebuild)
+  if (version >= 2) {
+    cacheKey.recordingChecksum = crc;
+    writePlanCache(planCachePath(filePath), cacheKey, start, plan,
+                   lastResample, lastTrim);
+  }
+  return true;
+}
+
+PlanCacheKey PositionReplay::planCacheKey(uint32_t checksum,
+                                          uint32_t sourceFrames) const {
+  PlanCacheKey key;
+  key.recordingChecksum = checksum;
+  key.sourceFrames = sourceFrames;
+  key.periodUs = gridPeriod * 1000;
+  key.nominalIntervalUs = recordingInterval * 1000;
+  key.trimEnabled = trimIdleEnabled;
+  key.trim = idleTrim;
+  return key;
+}
+
+// ==================== Embedded Recordings ====================
+
+bool PositionReplay::loadEmbedded(const asset &file) {
+  // Same buffer rules as an SD load
+  if (isLoading() || recordState != RecordState::Idle || _isPlaying) {
+    return false;
+  }
+  if (!readEmbedded(file)) {
+    return false;
+  }
+  loadState = LoadState::Ready;
+  master.print(0, 0, "EMBEDDED: %d pts   ", getFrameCount());
+  reportPlan();
+  return true;
+}
+
+bool PositionReplay::readFallback() {
+  if (!fallbackFile.buf || !readEmbedded(fallbackFile)) {
+    return false;
+  }
+  // Replaces the SD error on the screen; the rumble still flags it
+  master.print(0, 0, "FALLBACK: %d pts   ", getFrameCount());
+  master.rumble("-");
+  reportPlan();
   return true;
 }
 
+bool PositionReplay::readEmbedded(const asset &file) {
+  PlanCacheKey key;
+  CachedPlan embedded;
+  if (!readPlanInPlace(file.buf, file.size, MAX_CACHED_PLAN_FRAMES, key,
+                       embedded)) {
+    master.print(0, 0, "BAD EMBEDDED REC!  ");
+    master.rumble("---");
+    return false;
+  }
+
+  // The plan was built on the host; its frames are played from the linked
+  // bytes and never copied
+  recording.clear();
+  plan = std::move(embedded.plan);
+  planPeriodUs = plan.getPeriod();
+  lastResample = embedded.resample;
+  lastTrim = embedded.trim;
+  planFromCache = false;
+  sourceFrameCount = key.sourceFrames;
+  embeddedFile = file;
+  recordingChecksum = key.recordingChecksum;
+  const RecordingStartInfo &start = embedded.start;
+  recordingStartPose = lemlib::Pose(start.x, start.y, start.theta);
+  startWallDistance = start.wallDistance;
+  startPose = recordingStartPose;
+  applyTransform(loadTransform);
+  return true;
+}
+
+// ==================== Configuration ====================
+
+void PositionReplay::applyConfig(const TuningConfig &config) {
+  controller.setGains(config.gains);
+  ramsete.setGains(config.ramsete);
+  mpc.setGains(config.mpc);
+  recordingInterval = config.recordingInterval;
+  setGridPeriod(config.gridPeriod);
+  idleTrim.minDwellMs = config.idleDwell;
+  idleTrim.maxSpeed = config.idleSpeed;
+  trimIdleEnabled = config.trimIdle != 0;
+  countdownDuration = config.countdownDuration;
+  actionTriggerRadius = config.actionTriggerRadius;
+  actionTriggerMode = config.actionTrigger ? ActionTriggerMode::Position
+                                           : ActionTriggerMode::Time;
+  actionWindowMs = config.actionWindow;
+  resyncDistance = config.resyncDistance;
+  predictionHorizon = config.predictionHorizon;
+}
+
+// ==================== Transforms ====================
+
+void PositionReplay::applyTransform(const RecordingTransform &transform) {
+  PlanPlacement placement;
+  if (transform.mirrorX) {
+    PlanPlacement mirror; // y -> -y, theta -> 180 - theta
+    mirror.yy = -1;
+    mirror.mirrored = true;
+    mirror.headingOffset = 180.0f;
+    placement = placement.then(mirror);
+  }
+  if (transform.mirrorY) {
+    PlanPlacement mirror; // x -> -x, theta -> -theta
+    mirror.xx = -1;
+    mirror.mirrored = true;
+    placement = placement.then(mirror);
+  }
+
+  // Clockwise rotation (LemLib headings increase clockwise), then translation
+  float rad = transform.rotation * M_PI / 180.0f;
+  PlanPlacement move;
+  move.xx = std::cos(rad);
+  move.xy = std::sin(rad);
+  move.yx = -move.xy;
+  move.yy = move.xx;
+  move.dx = transform.offsetX;
+  move.dy = transform.offsetY;
+  move.headingOffset = transform.rotation;
+  placement = placement.then(move);
+
+  // The plan's frames aren't rewritten (they may be read-only); they're
+  // moved as playback decodes them
+  plan.place(placement);
+  placement.apply(startPose.x, startPose.y, startPose.theta);
+}
+
+void PositionReplay::rebaseToStartPose(const lemlib::Pose &pose) {
+  // Rotate about the origin so the start heading matches...
+  RecordingTransform transform;
+  transform.rotation = pose.theta - startPose.theta;
+
+  // ...then translate so the rotated start lands on the requested position
+  float rad = transform.rotation * M_PI / 180.0f;
+  float rotatedX = startPose.x * std::cos(rad) + startPose.y * std::sin(rad);
+  float rotatedY = -startPose.x * std::sin(rad) + startPose.y * std::cos(rad);
+  transform.offsetX = pose.x - rotatedX;
+  transform.offsetY = pose.y - rotatedY;
+
+  applyTransform(transform);
+}
+
+// ==================== Start Alignment ====================
+
+float PositionReplay::readWallDistance() {
+  if (!alignment.distanceSensor)
+    return -1;
+
+  // 9999 = nothing in range, PROS_ERR = sensor missing
+  int32_t mm = alignment.distanceSensor->get_distance();
+  if (mm <= 0 || mm >= 9999)
+    return -1;
+  return mm / 25.4f;
+}
+
+lemlib::Pose PositionReplay::estimateStartPose() {
+  lemlib::Pose actual = startPose;
+
+  // Heading: trust the IMU over the nominal start heading
+  if (alignment.useImuHeading) {
+    float heading = imu.get_heading() + alignment.imuHeadingOffset;
+    float error = heading - startPose.theta;
+    while (error > 180)
+      error -= 360;
+    while (error < -180)
+      error += 360;
+    actual.theta = startPose.theta + error;
+  }
+
+  // Position along the sensor beam: compare against the reading taken when
+  // the recording started. A mirrored recording points the sensor at a
+  // different wall, so the reading can't be compared there.
+  bool mirrored = loadTransform.mirrorX != loadTransform.mirrorY;
+  float measured = readWallDistance();
+  if (!mirrored && measured > 0 && startWallDistance > 0) {
+    float shift = startWallDistance - measured; // + = closer to the wall
+    if (std::abs(shift) <= alignment.maxCorrection) {
+      float beam = (actual.theta + alignment.sensorHeading) * M_PI / 180.0f;
+      actual.x += shift * std::sin(beam);
+      actual.y += shift * std::cos(beam);
+    }
+  }
+
+  return actual;
+}
+
 // ==================== Status Display ====================
 
 void PositionReplay::drawStatusIndicator() {
@@ -546,7 +1297,7 @@ void PositionReplay::drawStatusIndicator() {
   pros::screen::set_pen(pros::c::COLOR_BLACK);
   pros::screen::fill_rect(350, 0, 480, 50);
 
-  if (_isRecording) {
+  if (recordState == RecordState::Recording) {
     pros::screen::set_pen(pros::c::COLOR_CYAN);
     pros::screen::fill_circle(460, 20, 15);
     pros::screen::set_pen(pros::c::COLOR_WHITE);
@@ -556,11 +1307,11 @@ void PositionReplay::drawStatusIndicator() {
     pros::screen::fill_circle(460, 20, 15);
     pros::screen::set_pen(pros::c::COLOR_WHITE);
     pros::screen::print(pros::E_TEXT_SMALL, 360, 10, "PLAY");
-  } else if (!recording.empty()) {
+  } else if (getFrameCount() > 0) {
     pros::screen::set_pen(pros::c::COLOR_YELLOW);
     pros::screen::fill_circle(460, 20, 15);
     pros::screen::set_pen(pros::c::COLOR_WHITE);
     pros::screen::print(pros::E_TEXT_SMALL, 355, 10, "%d pts",
-                        recording.size());
+                        getFrameCount());
   }
 }
@@ -0,0 +1,60 @@
+#include "ramsete_controller.h"
+#include <algorithm>
+#include <cmath>
+
+static constexpr float INCHES_PER_METER = 39.37f;
+static constexpr float DEG_TO_RAD = M_PI / 180.0f;
+
+// With a stopped reference k would be 0 and nothing would pull the robot
+// back onto a paused target; this keeps some along-track correction
+static constexpr float MIN_GAIN = 1.5f; // 1/s
+
+static float wrapDegrees(float angle) {
+  return std::remainder(angle, 360.0f);
+}
+
+WheelSpeeds RamseteController::wheelSpeeds(const TrackingTarget &target,
+                                           float x, float y,
+                                           float theta) const {
+  // LemLib headings are clockwise from +Y; the law is written for the usual
+  // counter-clockwise-from-+X angle, so phi = 90 deg - theta
+  float phi = (90.0f - theta) * DEG_TO_RAD;
+  float c = std::cos(phi);
+  float s = std::sin(phi);
+
+  // Pose error in the robot's frame (x forward, y left)
+  float dx = target.x - x;
+  float dy = target.y - y;
+  float errorX = c * dx + s * dy;
+  float errorY = -s * dx + c * dy;
+  float errorTheta = -wrapDegrees(target.theta - theta) * DEG_TO_RAD;
+
+  float v = target.speed;
+  float w = -target.turnRate * DEG_TO_RAD; // Counter-clockwise rad/s
+  float b = gains.b / (INCHES_PER_METER * INCHES_PER_METER);
+
+  float k = std::max(2.0f * gains.zeta * std::sqrt(w * w + b * v * v), MIN_GAIN);
+  float sinc = std::fabs(errorTheta) < 1e-4f
+                   ? 1.0f
+                   : std::sin(errorTheta) / errorTheta;
+  float speed = v * std::cos(errorTheta) + k * errorX;
+  float turn = w + k * errorTheta + b * v * sinc * errorY;
+
+  float half = turn * gains.trackWidth / 2;
+  return {speed - half, speed + half};
+}
+
+DriveCommand RamseteController::update(const TrackingTarget &target, float x,
+                                       float y, float theta) {
+  WheelSpeeds wheels = wheelSpeeds(target, x, y, theta);
+  float left = wheels.left / gains.maxSpeed * 127;
+  float right = wheels.right / gains.maxSpeed * 127;
+
+  // Scale both sides down together so the curvature survives saturation
+  float peak = std::max(std::fabs(left), std::fabs(right));
+  if (peak > 127) {
+    left *= 127 / peak;
+    right *= 127 / peak;
+  }
+  return {(left + right) / 2, (left - right) / 2};
+}
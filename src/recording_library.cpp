@@ -0,0 +1,158 @@
+#include "recording_library.h"
+#include "position_replay.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+// Global instance
+RecordingLibrary recordingLibrary;
+
+// Catalog header values
+static constexpr uint32_t CATALOG_MAGIC = 0x52434154; // "RCAT"
+static constexpr uint32_t CATALOG_VERSION = 2; // v2 added CatalogEntry::tracking
+
+// Bytes per entry in a v1 catalog (everything before the tracking mode)
+static constexpr size_t CATALOG_V1_ENTRY = offsetof(CatalogEntry, tracking);
+
+RecordingLibrary::RecordingLibrary() { resetEntries(); }
+
+void RecordingLibrary::resetEntries() {
+  std::memset(entries, 0, sizeof(entries));
+  for (size_t i = 0; i < MAX_SLOTS; i++) {
+    std::snprintf(entries[i].name, sizeof(entries[i].name), "Slot %d",
+                  static_cast<int>(i + 1));
+  }
+  activeSlot = 0;
+}
+
+// ==================== Catalog ====================
+
+bool RecordingLibrary::loadCatalog() {
+  FILE *file = fopen(catalogPath.c_str(), "rb");
+  if (!file) {
+    resetEntries();
+    return false;
+  }
+
+  // Read header: magic + version + active slot + slot count
+  uint32_t header[4];
+  if (fread(header, sizeof(header), 1, file) != 1 ||
+      header[0] != CATALOG_MAGIC || header[1] < 1 ||
+      header[1] > CATALOG_VERSION || header[3] != MAX_SLOTS) {
+    fclose(file);
+    resetEntries();
+    return false;
+  }
+
+  // Read every entry in one go; v1 entries are shorter, so they are spread
+  // out in place (last first) and play with the default tracking law
+  size_t entrySize = header[1] == 1 ? CATALOG_V1_ENTRY : sizeof(CatalogEntry);
+  if (fread(entries, entrySize * MAX_SLOTS, 1, file) != 1) {
+    fclose(file);
+    resetEntries();
+    return false;
+  }
+  fclose(file);
+  if (entrySize != sizeof(CatalogEntry)) {
+    uint8_t *bytes = reinterpret_cast<uint8_t *>(entries);
+    for (size_t i = MAX_SLOTS; i-- > 0;) {
+      std::memmove(&entries[i], bytes + i * entrySize, entrySize);
+      entries[i].tracking = static_cast<uint8_t>(TrackingMode::Pursuit);
+    }
+  }
+
+  // Names come from the card - make sure they are terminated
+  for (size_t i = 0; i < MAX_SLOTS; i++) {
+    entries[i].name[sizeof(entries[i].name) - 1] = '\0';
+    if (entries[i].tracking > static_cast<uint8_t>(TrackingMode::Mpc))
+      entries[i].tracking = static_cast<uint8_t>(TrackingMode::Pursuit);
+  }
+
+  activeSlot = header[2] < MAX_SLOTS ? header[2] : 0;
+  positionReplay.setFilePath(slotPath(activeSlot));
+  positionReplay.setTrackingMode(
+      static_cast<TrackingMode>(entries[activeSlot].tracking));
+  return true;
+}
+
+bool RecordingLibrary::saveCatalog() {
+  FILE *file = fopen(catalogPath.c_str(), "wb");
+  if (!file) {
+    return false;
+  }
+
+  uint32_t header[4] = {CATALOG_MAGIC, CATALOG_VERSION,
+                        static_cast<uint32_t>(activeSlot),
+                        static_cast<uint32_t>(MAX_SLOTS)};
+  bool ok = fwrite(header, sizeof(header), 1, file) == 1 &&
+            fwrite(entries, sizeof(entries), 1, file) == 1;
+
+  fclose(file);
+  return ok;
+}
+
+void RecordingLibrary::updateActiveSlot(uint32_t frameCount,
+                                        uint32_t durationMs, uint32_t checksum,
+                                        float startX, float startY,
+                                        float startTheta) {
+  CatalogEntry &entry = entries[activeSlot];
+  entry.durationMs = durationMs;
+  entry.frameCount = frameCount;
+  entry.checksum = checksum;
+  entry.startX = startX;
+  entry.startY = startY;
+  entry.startTheta = startTheta;
+  entry.used = frameCount > 0 ? 1 : 0;
+  saveCatalog();
+}
+
+// ==================== Slots ====================
+
+bool RecordingLibrary::selectSlot(size_t slot) {
+  if (slot >= MAX_SLOTS || positionReplay.isLoading() ||
+      positionReplay.isSaving())
+    return false;
+
+  activeSlot = slot;
+  positionReplay.setFilePath(slotPath(slot));
+  positionReplay.setTrackingMode(
+      static_cast<TrackingMode>(entries[slot].tracking));
+  saveCatalog(); // Remember the selection across power cycles
+
+  if (!entries[slot].used) {
+    positionReplay.clearRecording();
+    return false;
+  }
+
+  // Load in the background so the menu stays responsive
+  positionReplay.loadFromSDAsync();
+  return true;
+}
+
+std::string RecordingLibrary::slotPath(size_t slot) const {
+  // Slot 1 keeps the original file name so existing recordings still load
+  if (slot == 0)
+    return "/usd/position_recording.bin";
+
+  char path[32];
+  std::snprintf(path, sizeof(path), "/usd/recording_%d.bin",
+                static_cast<int>(slot + 1));
+  return path;
+}
+
+void RecordingLibrary::setSlotName(size_t slot, const char *name) {
+  if (slot >= MAX_SLOTS)
+    return;
+  std::strncpy(entries[slot].name, name, sizeof(entries[slot].name) - 1);
+  entries[slot].name[sizeof(entries[slot].name) - 1] = '\0';
+  saveCatalog();
+}
+
+void RecordingLibrary::setSlotTracking(size_t slot, TrackingMode mode) {
+  if (slot >= MAX_SLOTS)
+    return;
+  entries[slot].tracking = static_cast<uint8_t>(mode);
+  if (slot == activeSlot)
+    positionReplay.setTrackingMode(mode);
+  saveCatalog();
+}
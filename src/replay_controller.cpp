@@ -0,0 +1,73 @@
+#include "replay_controller.h"
+#include <cmath>
+
+static float clampPower(float power) {
+  if (power > 127)
+    return 127;
+  if (power < -127)
+    return -127;
+  return power;
+}
+
+static float wrapDegrees(float angle) {
+  while (angle > 180)
+    angle -= 360;
+  while (angle < -180)
+    angle += 360;
+  return angle;
+}
+
+DriveCommand ReplayController::update(float targetX, float targetY,
+                                      float targetTheta, float x, float y,
+                                      float theta) {
+  // --- CUSTOM LIGHTWEIGHT PURE PURSUIT ---
+  // We act like a pursuit controller following the moving target point
+  float dx = targetX - x;
+  float dy = targetY - y;
+  float distance = std::sqrt(dx * dx + dy * dy);
+
+  // Calculate desired heading toward target, in LemLib's convention
+  // (0 = +Y, clockwise positive) so it compares directly with theta
+  float targetHeading = std::atan2(dx, dy) * 180.0f / M_PI;
+  float headingError = wrapDegrees(targetHeading - theta);
+
+  // Calculate derivative terms
+  float distanceDerivative = distance - prevDistanceError;
+  float headingDerivative = headingError - prevHeadingError;
+
+  float forward =
+      distance * gains.kP_forward + distanceDerivative * gains.kD_forward;
+  float turn = headingError * gains.kP_turn + headingDerivative * gains.kD_turn;
+
+  // Update previous errors for next iteration
+  prevDistanceError = distance;
+  prevHeadingError = headingError;
+
+  // Determine if robot should be driving backward:
+  // Dot product of robot's heading vector with target direction vector
+  // If negative, the target is behind the robot, so drive in reverse.
+  float headingRad = theta * M_PI / 180.0f;
+  float forwardDotProduct =
+      dx * std::sin(headingRad) + dy * std::cos(headingRad);
+  if (forwardDotProduct < 0) {
+    forward = -forward;
+  }
+
+  forward = clampPower(forward);
+  turn = clampPower(turn);
+
+  // Special case: If we are extremely close to the point (within 0.5 inch),
+  // match the recorded heading instead of driving to the point
+  if (distance < 0.5f) {
+    forward = 0;
+    float thetaError = wrapDegrees(targetTheta - theta);
+
+    // Use same PD values for heading correction
+    float thetaDerivative = thetaError - prevHeadingError;
+    turn = clampPower(thetaError * gains.kP_turn +
+                      thetaDerivative * gains.kD_turn);
+    prevHeadingError = thetaError;
+  }
+
+  return {forward, turn};
+}
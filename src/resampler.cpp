@@ -0,0 +1,103 @@
+#include "resampler.h"
+#include <algorithm>
+#include <cmath>
+
+// Presses that toggle a piston during playback
+static constexpr uint8_t TOGGLE_MASK = (1 << BTN_X) | (1 << BTN_A) | (1 << BTN_B);
+
+void GridResampler::begin(std::vector<GridFrame> &out, uint32_t periodUs,
+                          uint32_t nominalIntervalUs) {
+  this->out = &out;
+  this->periodUs = periodUs > 0 ? periodUs : 10000;
+  nominalUs = nominalIntervalUs > 0 ? nominalIntervalUs : 25000;
+  nextTime = 0;
+  hasPrev = false;
+  pendingToggles = 0;
+  pendingAction = false;
+  report = ResampleReport();
+  out.clear();
+}
+
+void GridResampler::emit(const WaypointFrame &from, const WaypointFrame &to,
+                         uint64_t time) {
+  GridFrame frame;
+  float t = 0;
+  if (to.timestamp > from.timestamp && time > from.timestamp) {
+    t = std::min(1.0f, static_cast<float>(time - from.timestamp) /
+                           (to.timestamp - from.timestamp));
+  }
+  frame.x = from.x + (to.x - from.x) * t;
+  frame.y = from.y + (to.y - from.y) * t;
+
+  // Shortest way round, so a heading that wraps doesn't spin the long way
+  float dTheta = std::remainder(to.theta - from.theta, 360.0f);
+  frame.theta = from.theta + dTheta * t;
+
+  // Mechanisms never run ahead of the recording
+  const WaypointFrame &held = time >= to.timestamp ? to : from;
+  frame.intakePower = held.intakePower;
+  frame.outtakePower = held.outtakePower;
+  frame.toggles = pendingToggles;
+  frame.hasAction = pendingAction;
+  pendingToggles = 0;
+  pendingAction = false;
+
+  out->push_back(frame);
+}
+
+void GridResampler::add(const WaypointFrame &frame) {
+  report.sourceFrames++;
+
+  if (hasPrev) {
+    if (frame.timestamp <= prev.timestamp) {
+      report.outOfOrder++;
+      return;
+    }
+    uint64_t gap = frame.timestamp - prev.timestamp;
+    report.longestGapMs =
+        std::max(report.longestGapMs, static_cast<uint32_t>(gap / 1000));
+    if (gap * 2 > nominalUs * 3) {
+      report.droppedSamples += (gap + nominalUs / 2) / nominalUs - 1;
+    }
+  }
+
+  // Grid points before this frame lie between it and the previous one
+  // (before the first frame they hold its pose)
+  const WaypointFrame &from = hasPrev ? prev : frame;
+  while (nextTime < frame.timestamp) {
+    emit(from, frame, nextTime);
+    nextTime += periodUs;
+  }
+
+  // Presses take effect at the first grid point at or after them. XOR keeps
+  // the parity, so a double tap between two points cancels out exactly as
+  // it would have on the robot.
+  uint8_t pressed = frame.buttons & ~(hasPrev ? prev.buttons : 0);
+  pendingToggles ^= pressed & TOGGLE_MASK;
+  pendingAction = pendingAction || frame.hasAction;
+
+  prev = frame;
+  hasPrev = true;
+}
+
+ResampleReport GridResampler::finish() {
+  if (hasPrev) {
+    emit(prev, prev, nextTime);
+    nextTime += periodUs;
+  }
+  report.gridFrames = out ? out->size() : 0;
+  return report;
+}
+
+ResampleReport resampleToGrid(const WaypointFrame *frames, size_t count,
+                              uint32_t periodUs, uint32_t nominalIntervalUs,
+                              std::vector<GridFrame> &out) {
+  GridResampler resampler;
+  resampler.begin(out, periodUs, nominalIntervalUs);
+  out.reserve(count > 0 ? frames[count - 1].timestamp / resampler.getPeriod() + 2
+                        : 0);
+  for (size_t i = 0; i < count; i++) {
+    resampler.add(frames[i]);
+  }
+  return resampler.finish();
+}
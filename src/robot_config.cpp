@@ -1,4 +1,5 @@
 #include "robot_config.h"
+#include "odom_scheduler.h"
 #include "pros/rtos.hpp" // For pros::Task
 
 // Vertical Tracking Wheel
@@ -24,6 +25,14 @@ lemlib::TrackingWheel vertical_tracking_wheel(&rotation_sensor,
                                               lemlib::Omniwheel::NEW_275, -.25);
 // vertical wheel, 2.75" diameter, -.25" offset from tracking center
 
+// drive motors as tracking wheels (the right side is what chassis.calibrate()
+// would create for the missing second vertical wheel; both feed odom fusion)
+lemlib::TrackingWheel left_drive_wheel(&left_motors, lemlib::Omniwheel::NEW_325,
+                                       -11.5 / 2, 450);
+lemlib::TrackingWheel right_drive_wheel(&right_motors,
+                                        lemlib::Omniwheel::NEW_325, 11.5 / 2,
+                                        450);
+
 // odometry sensors configuration
 lemlib::OdomSensors sensors(&vertical_tracking_wheel, // vertical tracking wheel
                             nullptr, // no second vertical wheel
@@ -81,8 +90,10 @@ pros::adi::DigitalOut MidScoring('B');
 pros::Controller master(pros::E_CONTROLLER_MASTER);
 
 void initializeRobot() {
-  // Non-blocking calibration - fixes "Run" mode hang
-  chassis.calibrate(false);
+  // Odometry runs on our own task (configurable period/priority) instead of
+  // the fixed-rate one chassis.calibrate() starts. Like calibrate(false),
+  // this doesn't block on IMU calibration - fixes "Run" mode hang
+  odomScheduler.start();
 
   // Set brake modes
   left_motors.set_brake_mode(
@@ -0,0 +1,169 @@
+#include "run_log.h"
+#include "crc32.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// Run log file format: header (magic, version, sample count, recording
+// checksum) + summary + samples + CRC-32 trailer over everything before it
+static constexpr uint32_t RUN_LOG_MAGIC = 0x524C4F47; // "RLOG"
+static constexpr uint32_t RUN_LOG_VERSION = 1;
+
+// Samples searched either side of a sample when projecting onto the path.
+// Looking further back lets a robot that fell well behind still find the
+// part of the path it is actually on.
+static constexpr size_t SEARCH_BACK = 100;
+static constexpr size_t SEARCH_AHEAD = 25;
+
+static float wrapDegrees(float angle) {
+  while (angle > 180)
+    angle -= 360;
+  while (angle < -180)
+    angle += 360;
+  return angle;
+}
+
+// ==================== Capture ====================
+
+void RunLog::begin(uint32_t checksum) {
+  samples.clear();
+  samples.reserve(MAX_SAMPLES);
+  summary = {};
+  recordingChecksum = checksum;
+  overflowed = false;
+}
+
+const RunSummary &RunLog::finish(float finalX, float finalY,
+                                 float finalTheta) {
+  summary = {};
+  summary.sampleCount = samples.size();
+  if (samples.empty())
+    return summary;
+
+  double sumSquares = 0;
+  double sumBehind = 0;
+  for (size_t i = 0; i < samples.size(); i++) {
+    SampleError error = measure(i);
+    sumSquares += error.crossTrack * error.crossTrack;
+    sumBehind += error.timeBehind;
+    summary.maxCrossTrack = std::max(summary.maxCrossTrack, error.crossTrack);
+    summary.maxTimeBehind = std::max(summary.maxTimeBehind, error.timeBehind);
+  }
+  summary.rmsCrossTrack = std::sqrt(sumSquares / samples.size());
+  summary.meanTimeBehind = sumBehind / samples.size();
+
+  const RunSample &last = samples.back();
+  summary.durationMs = last.elapsedMs;
+  summary.finalPositionError =
+      std::hypot(finalX - last.x, finalY - last.y);
+  summary.finalHeadingError = std::fabs(wrapDegrees(finalTheta - last.theta));
+  return summary;
+}
+
+// ==================== Analysis ====================
+
+SampleError RunLog::measure(size_t index) const {
+  const RunSample &sample = samples[index];
+  size_t first = index > SEARCH_BACK ? index - SEARCH_BACK : 0;
+  size_t last = std::min(index + SEARCH_AHEAD, samples.size() - 1);
+
+  // Single target point (start of the run or a held frame)
+  float bestDistance = std::hypot(sample.x - samples[first].targetX,
+                                  sample.y - samples[first].targetY);
+  float bestTime = samples[first].targetMs;
+
+  // Project onto each segment between consecutive targets
+  for (size_t i = first; i < last; i++) {
+    const RunSample &a = samples[i];
+    const RunSample &b = samples[i + 1];
+    float segX = b.targetX - a.targetX;
+    float segY = b.targetY - a.targetY;
+    float lengthSquared = segX * segX + segY * segY;
+
+    float t = 0;
+    if (lengthSquared > 1e-6f) {
+      t = ((sample.x - a.targetX) * segX + (sample.y - a.targetY) * segY) /
+          lengthSquared;
+      t = std::clamp(t, 0.0f, 1.0f);
+    }
+    float distance = std::hypot(sample.x - (a.targetX + t * segX),
+                                sample.y - (a.targetY + t * segY));
+    if (distance < bestDistance) {
+      bestDistance = distance;
+      bestTime = a.targetMs +
+                 t * (static_cast<float>(b.targetMs) - a.targetMs);
+    }
+  }
+
+  return {bestDistance, sample.elapsedMs - bestTime};
+}
+
+// ==================== Storage ====================
+
+std::string RunLog::pathFor(const std::string &recordingPath) {
+  size_t dot = recordingPath.rfind('.');
+  size_t slash = recordingPath.rfind('/');
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    return recordingPath + ".run";
+  return recordingPath.substr(0, dot) + ".run";
+}
+
+bool RunLog::save(const std::string &path) const {
+  FILE *file = fopen(path.c_str(), "wb");
+  if (!file) {
+    return false;
+  }
+
+  uint32_t header[4] = {RUN_LOG_MAGIC, RUN_LOG_VERSION,
+                        static_cast<uint32_t>(samples.size()),
+                        recordingChecksum};
+  uint32_t crc = crc32(header, sizeof(header));
+  crc = crc32(&summary, sizeof(summary), crc);
+  crc = crc32(samples.data(), samples.size() * sizeof(RunSample), crc);
+
+  bool ok = fwrite(header, sizeof(header), 1, file) == 1 &&
+            fwrite(&summary, sizeof(summary), 1, file) == 1 &&
+            fwrite(samples.data(), sizeof(RunSample), samples.size(), file) ==
+                samples.size() &&
+            fwrite(&crc, sizeof(crc), 1, file) == 1;
+
+  fclose(file);
+  return ok;
+}
+
+bool RunLog::load(const std::string &path) {
+  FILE *file = fopen(path.c_str(), "rb");
+  if (!file) {
+    return false;
+  }
+
+  uint32_t header[4];
+  if (fread(header, sizeof(header), 1, file) != 1 ||
+      header[0] != RUN_LOG_MAGIC || header[1] != RUN_LOG_VERSION ||
+      header[2] > MAX_SAMPLES) {
+    fclose(file);
+    return false;
+  }
+
+  RunSummary stored;
+  samples.resize(header[2]);
+  uint32_t storedCrc;
+  bool ok = fread(&stored, sizeof(stored), 1, file) == 1 &&
+            fread(samples.data(), sizeof(RunSample), samples.size(), file) ==
+                samples.size() &&
+            fread(&storedCrc, sizeof(storedCrc), 1, file) == 1;
+  fclose(file);
+
+  uint32_t crc = crc32(header, sizeof(header));
+  crc = crc32(&stored, sizeof(stored), crc);
+  crc = crc32(samples.data(), samples.size() * sizeof(RunSample), crc);
+  if (!ok || crc != storedCrc) {
+    samples.clear();
+    return false;
+  }
+
+  summary = stored;
+  recordingChecksum = header[3];
+  overflowed = false;
+  return true;
+}
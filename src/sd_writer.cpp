@@ -0,0 +1,119 @@
+#include "sd_writer.h"
+#include "crc32.h"
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+
+// Global instance
+SdWriter sdWriter;
+
+// ==================== File Writing ====================
+
+bool writeRecordingFile(const std::string &path,
+                        const RecordingStartInfo &start,
+                        const FrameStore &frames, uint32_t &checksum) {
+  // Write to a temp file first so the existing recording survives a crash,
+  // brown-out or card pull in the middle of the save
+  std::string tempPath = path + ".tmp";
+  FILE *file = fopen(tempPath.c_str(), "wb");
+  if (!file) {
+    return false;
+  }
+
+  // Write header: magic number + version + frame count
+  uint32_t header[3] = {RECORDING_MAGIC, RECORDING_VERSION,
+                        static_cast<uint32_t>(frames.size())};
+  bool ok = fwrite(header, sizeof(header), 1, file) == 1 &&
+            fwrite(&start, sizeof(start), 1, file) == 1;
+  uint32_t crc = crc32(header, sizeof(header));
+  crc = crc32(&start, sizeof(start), crc);
+
+  // Widen the frames back to the file format a block at a time, folding
+  // each block into the CRC as it goes out
+  WaypointFrame block[32];
+  size_t pending = 0;
+  auto flush = [&]() {
+    ok = ok && fwrite(block, sizeof(WaypointFrame), pending, file) == pending;
+    crc = crc32(block, pending * sizeof(WaypointFrame), crc);
+    pending = 0;
+  };
+  for (const WaypointFrame &frame : frames) {
+    block[pending++] = frame;
+    if (pending == std::size(block))
+      flush();
+  }
+  flush();
+
+  // CRC-32 trailer over header + frames
+  ok = ok && fwrite(&crc, sizeof(uint32_t), 1, file) == 1;
+  if (fclose(file) != 0) {
+    ok = false;
+  }
+
+  if (!ok || !replaceFile(tempPath, path)) {
+    remove(tempPath.c_str());
+    return false;
+  }
+
+  checksum = crc;
+  return true;
+}
+
+// ==================== I/O Task ====================
+
+void SdWriter::start() {
+  if (task)
+    return;
+
+  // Below opcontrol so the card never takes time from driving
+  task = new pros::Task([this]() { run(); }, TASK_PRIORITY_DEFAULT - 2,
+                        TASK_STACK_DEPTH_DEFAULT, "sd writer");
+}
+
+void SdWriter::run() {
+  while (true) {
+    // Sleep until submit() has something
+    pros::Task::notify_take(true, TIMEOUT_MAX);
+
+    while (true) {
+      RecordingSaveJob job;
+      {
+        std::lock_guard<pros::Mutex> lock(mutex);
+        if (pending.empty()) {
+          busy = false;
+          break;
+        }
+        job = std::move(pending.front());
+        pending.pop_front();
+      }
+
+      uint32_t startTime = pros::millis();
+      job.ok = writeRecordingFile(job.path, job.start, job.frames,
+                                  job.checksum);
+      job.writeTimeMs = pros::millis() - startTime;
+
+      if (job.onComplete) {
+        job.onComplete(job);
+      }
+    }
+  }
+}
+
+bool SdWriter::submit(RecordingSaveJob &&job) {
+  start();
+  {
+    std::lock_guard<pros::Mutex> lock(mutex);
+    if (pending.size() >= MAX_PENDING) {
+      return false;
+    }
+    pending.push_back(std::move(job));
+    busy = true;
+  }
+  task->notify();
+  return true;
+}
+
+bool SdWriter::isBusy() {
+  std::lock_guard<pros::Mutex> lock(mutex);
+  return busy;
+}
@@ -0,0 +1,60 @@
+#include "spatial_grid.h"
+#include <algorithm>
+#include <cmath>
+
+int SpatialGrid::cellOf(float value, float origin) const {
+  return static_cast<int>(std::floor((value - origin) / size));
+}
+
+void SpatialGrid::clear() {
+  cellStart.clear();
+  cellPoints.clear();
+  cols = rows = 0;
+}
+
+void SpatialGrid::build(const std::vector<GridPoint> &points, float cellSize) {
+  clear();
+  size = cellSize;
+  if (points.empty())
+    return;
+
+  minX = points[0].x;
+  minY = points[0].y;
+  float maxX = minX, maxY = minY;
+  for (const GridPoint &point : points) {
+    minX = std::min(minX, point.x);
+    minY = std::min(minY, point.y);
+    maxX = std::max(maxX, point.x);
+    maxY = std::max(maxY, point.y);
+  }
+  while (true) {
+    cols = cellOf(maxX, minX) + 1;
+    rows = cellOf(maxY, minY) + 1;
+    if (cols * rows <= MAX_CELLS)
+      break;
+    size *= 2;
+  }
+
+  // Counting sort by cell; points stay in index order within each cell
+  std::vector<uint32_t> cellOfPoint(points.size());
+  cellStart.assign(cols * rows + 1, 0);
+  for (size_t i = 0; i < points.size(); i++) {
+    cellOfPoint[i] = row(points[i].y) * cols + col(points[i].x);
+    cellStart[cellOfPoint[i] + 1]++;
+  }
+  for (size_t c = 1; c < cellStart.size(); c++) {
+    cellStart[c] += cellStart[c - 1];
+  }
+  cellPoints.resize(points.size());
+  std::vector<uint32_t> fill(cellStart.begin(), cellStart.end() - 1);
+  for (size_t i = 0; i < points.size(); i++) {
+    cellPoints[fill[cellOfPoint[i]]++] = i;
+  }
+}
+
+SpatialGrid::Cell SpatialGrid::cell(int col, int row) const {
+  if (col < 0 || col >= cols || row < 0 || row >= rows)
+    return {};
+  int c = row * cols + col;
+  return {cellPoints.data() + cellStart[c], cellPoints.data() + cellStart[c + 1]};
+}
@@ -0,0 +1,210 @@
+#include "tuning_config.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Global instance
+TuningFile tuningFile;
+
+// ==================== Keys ====================
+
+enum class FieldType { Float, Uint, Int };
+
+// One recognised key: name, type, where it lives and what it's for
+struct TuningField {
+  const char *key;
+  FieldType type;
+  void *(*field)(TuningConfig &);
+  const char *comment;
+  uint32_t min = 1; // Smallest accepted value (Uint keys)
+};
+
+static const TuningField FIELDS[] = {
+    {"kP_forward", FieldType::Float,
+     [](TuningConfig &c) -> void * { return &c.gains.kP_forward; },
+     "Playback lateral kP"},
+    {"kD_forward", FieldType::Float,
+     [](TuningConfig &c) -> void * { return &c.gains.kD_forward; },
+     "Playback lateral kD"},
+    {"kP_turn", FieldType::Float,
+     [](TuningConfig &c) -> void * { return &c.gains.kP_turn; },
+     "Playback angular kP"},
+    {"kD_turn", FieldType::Float,
+     [](TuningConfig &c) -> void * { return &c.gains.kD_turn; },
+     "Playback angular kD"},
+    {"ramsete_b", FieldType::Float,
+     [](TuningConfig &c) -> void * { return &c.ramsete.b; },
+     "Ramsete convergence gain (1/m^2) - higher corrects pose error harder"},
+    {"ramsete_zeta", FieldType::Float,
+     [](TuningConfig &c) -> void * { return &c.ramsete.zeta; },
+     "Ramsete damping (0-1)"},
+    {"mpc_horizon", FieldType::Uint,
+     [](TuningConfig &c) -> void * { return &c.mpc.horizon; },
+     "MPC ticks looked ahead (1-30) - see tools/mpc_horizon_bench.cpp"},
+    {"mpc_iterations", FieldType::Uint,
+     [](TuningConfig &c) -> void * { return &c.mpc.iterations; },
+     "MPC solver iterations per tick"},
+    {"mpc_heading_weight", FieldType::Float,
+     [](TuningConfig &c) -> void * { return &c.mpc.headingWeight; },
+     "MPC cost per rad^2 of heading error (1 per in^2 off)"},
+    {"mpc_input_weight", FieldType::Float,
+     [](TuningConfig &c) -> void * { return &c.mpc.inputWeight; },
+     "MPC cost of power off the plan's - higher is smoother"},
+    {"recording_interval", FieldType::Uint,
+     [](TuningConfig &c) -> void * { return &c.recordingInterval; },
+     "ms between recorded frames"},
+    {"grid_period", FieldType::Uint,
+     [](TuningConfig &c) -> void * { return &c.gridPeriod; },
+     "ms between playback frames (resampled at load)"},
+    {"trim_idle", FieldType::Uint,
+     [](TuningConfig &c) -> void * { return &c.trimIdle; },
+     "1 = shorten pauses in recordings at load, 0 = play them as recorded",
+     0},
+    {"idle_dwell", FieldType::Uint,
+     [](TuningConfig &c) -> void * { return &c.idleDwell; },
+     "ms each shortened pause keeps"},
+    {"idle_speed", FieldType::Float,
+     [](TuningConfig &c) -> void * { return &c.idleSpeed; },
+     "in/s below which the robot counts as stopped"},
+    {"countdown", FieldType::Uint,
+     [](TuningConfig &c) -> void * { return &c.countdownDuration; },
+     "ms countdown before recording", 0},
+    {"action_radius", FieldType::Float,
+     [](TuningConfig &c) -> void * { return &c.actionTriggerRadius; },
+     "Inches - action trigger radius"},
+    {"action_trigger", FieldType::Uint,
+     [](TuningConfig &c) -> void * { return &c.actionTrigger; },
+     "0 = mechanism actions play by time, 1 = where they were recorded", 0},
+    {"action_window", FieldType::Uint,
+     [](TuningConfig &c) -> void * { return &c.actionWindow; },
+     "ms a position-triggered action may be early or late", 0},
+    {"resync_distance", FieldType::Float,
+     [](TuningConfig &c) -> void * { return &c.resyncDistance; },
+     "Inches off the path before playback rejoins it (0 = off)"},
+    {"prediction_horizon", FieldType::Float,
+     [](TuningConfig &c) -> void * { return &c.predictionHorizon; },
+     "ms pose prediction (0 = off, -1 = loop period)"},
+    {"deadband", FieldType::Int,
+     [](TuningConfig &c) -> void * { return &c.driveDeadband; },
+     "Joystick deadband (0-127)"},
+};
+
+// Strip leading/trailing whitespace in place
+static char *trim(char *text) {
+  while (std::isspace(static_cast<unsigned char>(*text)))
+    text++;
+  char *end = text + std::strlen(text);
+  while (end > text && std::isspace(static_cast<unsigned char>(end[-1])))
+    end--;
+  *end = '\0';
+  return text;
+}
+
+bool TuningFile::parseLine(char *line) {
+  // Comments run to the end of the line
+  char *hash = std::strchr(line, '#');
+  if (hash)
+    *hash = '\0';
+
+  char *equals = std::strchr(line, '=');
+  if (!equals)
+    return false;
+  *equals = '\0';
+  char *key = trim(line);
+  char *value = trim(equals + 1);
+
+  for (const TuningField &field : FIELDS) {
+    if (std::strcmp(key, field.key) != 0)
+      continue;
+
+    char *end;
+    double number = std::strtod(value, &end);
+    if (end == value || *end != '\0')
+      return false;
+
+    void *target = field.field(config);
+    switch (field.type) {
+    case FieldType::Float:
+      *static_cast<float *>(target) = number;
+      break;
+    case FieldType::Uint:
+      if (number < field.min)
+        return false;
+      *static_cast<uint32_t *>(target) = number;
+      break;
+    case FieldType::Int:
+      *static_cast<int32_t *>(target) = number;
+      break;
+    }
+    return true;
+  }
+  return false; // Unknown key
+}
+
+// ==================== File I/O ====================
+
+bool TuningFile::load() {
+  config = TuningConfig();
+  keysRead = 0;
+  badLines = 0;
+
+  FILE *file = fopen(path.c_str(), "r");
+  if (!file) {
+    // First boot with this card - leave a template to edit
+    save();
+    return false;
+  }
+
+  char line[96];
+  while (fgets(line, sizeof(line), file)) {
+    // Only the start of an overlong line is parsed; the rest (in practice a
+    // long comment) is skipped rather than read as a line of its own
+    if (!std::strchr(line, '\n')) {
+      int c;
+      while ((c = fgetc(file)) != '\n' && c != EOF) {
+      }
+    }
+    char *text = trim(line);
+    if (*text == '\0' || *text == '#')
+      continue;
+    if (parseLine(text))
+      keysRead++;
+    else
+      badLines++;
+  }
+
+  fclose(file);
+  return true;
+}
+
+bool TuningFile::save() const {
+  FILE *file = fopen(path.c_str(), "w");
+  if (!file) {
+    return false;
+  }
+
+  TuningConfig copy = config;
+  fprintf(file, "# Position recorder tuning - tap CFG on the brain to reload\n");
+  for (const TuningField &field : FIELDS) {
+    void *value = field.field(copy);
+    switch (field.type) {
+    case FieldType::Float:
+      fprintf(file, "%s = %g", field.key, *static_cast<float *>(value));
+      break;
+    case FieldType::Uint:
+      fprintf(file, "%s = %lu", field.key,
+              static_cast<unsigned long>(*static_cast<uint32_t *>(value)));
+      break;
+    case FieldType::Int:
+      fprintf(file, "%s = %ld", field.key,
+              static_cast<long>(*static_cast<int32_t *>(value)));
+      break;
+    }
+    fprintf(file, "    # %s\n", field.comment);
+  }
+
+  bool ok = !ferror(file);
+  fclose(file);
+  return ok;
+}
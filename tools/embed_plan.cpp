@@ -0,0 +1,142 @@
+/**
+ * Host builder for embedded recordings
+ *
+ * Builds the playback plan for a recording the way the brain does on an SD
+ * load (resample, idle trim, quantize, derive motion) and writes it as a
+ * .plan file: the plan cache layout from plan_cache.h. The Makefile runs
+ * this for every recordings/*.bin and links the plans into the cold package,
+ * where loadEmbedded() plays them in place.
+ *
+ * The grid period, recording interval and idle trim come from the tuning
+ * file if one is given (the defaults otherwise), so pass the robot's
+ * tuning.cfg if it changes them.
+ *
+ * Build & run from the project root:
+ *   g++ -O2 -std=c++20 -Iinclude tools/embed_plan.cpp src/plan_cache.cpp src/file_replace.cpp src/compact_plan.cpp src/resampler.cpp src/idle_trim.cpp src/tuning_config.cpp src/crc32.cpp -o embed_plan
+ *   ./embed_plan recordings/match_left.bin recordings/match_left.plan [tuning.cfg]
+ */
+#include "crc32.h"
+#include "idle_trim.h"
+#include "plan_cache.h"
+#include "resampler.h"
+#include "tuning_config.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+// Longest plan the brain accepts (PositionReplay::MAX_CACHED_PLAN_FRAMES)
+static constexpr size_t MAX_PLAN_FRAMES = 60000;
+
+// Read and check a recording file as readRecordingFile() does on the brain
+static bool readRecording(const char *path, std::vector<WaypointFrame> &frames,
+                          RecordingStartInfo &start, uint32_t &checksum) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    std::fprintf(stderr, "can't open %s\n", path);
+    return false;
+  }
+
+  uint32_t header[3];
+  if (fread(header, sizeof(header), 1, file) != 1 ||
+      header[0] != RECORDING_MAGIC || header[1] > RECORDING_VERSION) {
+    std::fprintf(stderr, "%s is not a recording\n", path);
+    fclose(file);
+    return false;
+  }
+  uint32_t crc = crc32(header, sizeof(header));
+
+  // Older files were always recorded from (0, 0, 0) without a wall reading
+  start = {0, 0, 0, -1};
+  if (header[1] >= 3) {
+    if (fread(&start, sizeof(start), 1, file) != 1) {
+      std::fprintf(stderr, "%s is truncated\n", path);
+      fclose(file);
+      return false;
+    }
+    crc = crc32(&start, sizeof(start), crc);
+  }
+
+  frames.resize(header[2]);
+  if (fread(frames.data(), sizeof(WaypointFrame), frames.size(), file) !=
+      frames.size()) {
+    std::fprintf(stderr, "%s is truncated\n", path);
+    fclose(file);
+    return false;
+  }
+  crc = crc32(frames.data(), frames.size() * sizeof(WaypointFrame), crc);
+
+  uint32_t storedCrc;
+  if (header[1] >= 2 && (fread(&storedCrc, sizeof(storedCrc), 1, file) != 1 ||
+                         storedCrc != crc)) {
+    std::fprintf(stderr, "%s: CRC mismatch\n", path);
+    fclose(file);
+    return false;
+  }
+  fclose(file);
+  checksum = crc;
+  return true;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    std::fprintf(stderr, "usage: %s recording.bin out.plan [tuning.cfg]\n",
+                 argv[0]);
+    return 1;
+  }
+
+  TuningConfig config;
+  if (argc > 3) {
+    tuningFile.setPath(argv[3]);
+    if (!tuningFile.load()) {
+      std::fprintf(stderr, "can't read %s\n", argv[3]);
+      return 1;
+    }
+    config = tuningFile.get();
+  }
+
+  std::vector<WaypointFrame> frames;
+  RecordingStartInfo start;
+  uint32_t checksum;
+  if (!readRecording(argv[1], frames, start, checksum))
+    return 1;
+
+  // Same key the brain would cache this build under (see
+  // PositionReplay::planCacheKey() and applyConfig())
+  PlanCacheKey key;
+  key.recordingChecksum = checksum;
+  key.sourceFrames = frames.size();
+  key.periodUs = std::max<uint32_t>(config.gridPeriod, 1) * 1000;
+  key.nominalIntervalUs = config.recordingInterval * 1000;
+  key.trimEnabled = config.trimIdle != 0;
+  key.trim.minDwellMs = config.idleDwell;
+  key.trim.maxSpeed = config.idleSpeed;
+
+  std::vector<GridFrame> grid;
+  ResampleReport resample = resampleToGrid(
+      frames.data(), frames.size(), key.periodUs, key.nominalIntervalUs, grid);
+  IdleTrimReport trim;
+  if (key.trimEnabled)
+    trim = trimIdle(grid, key.periodUs, key.trim);
+  if (grid.empty() || grid.size() > MAX_PLAN_FRAMES) {
+    std::fprintf(stderr, "%s: plan of %zu frames (1 to %zu allowed)\n", argv[1],
+                 grid.size(), MAX_PLAN_FRAMES);
+    return 1;
+  }
+
+  CompactPlan plan;
+  plan.encode(grid, key.periodUs);
+  if (!writePlanCache(argv[2], key, start, plan, resample, trim)) {
+    std::fprintf(stderr, "can't write %s\n", argv[2]);
+    return 1;
+  }
+
+  std::printf("%s: %zu frames -> %zu plan frames on a %u ms grid (%.1f KB)",
+              argv[2], frames.size(), plan.size(), key.periodUs / 1000,
+              plan.bytes() / 1024.0);
+  if (resample.droppedSamples > 0)
+    std::printf(", %u dropped", resample.droppedSamples);
+  if (trim.intervals > 0)
+    std::printf(", %.1f s idle trimmed", trim.secondsSaved);
+  std::printf("\n");
+  return 0;
+}
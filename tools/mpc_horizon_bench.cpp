@@ -0,0 +1,106 @@
+/**
+ * MPC horizon benchmark
+ *
+ * Plays a corpus of recordings through MpcController at a range of horizon
+ * lengths, against the drivetrain model in replay_sim.h and against a
+ * mismatched one (slower, laggier motors, older odometry and a longer tick
+ * than the controller's defaults assume). For each N it reports the tracking error and the
+ * time of every update() call: min, mean, 99th percentile and worst.
+ *
+ * The solver does the same work for every call at a given N and iteration
+ * budget (condensing grows as N^3, the iterations as N^2). The spread above
+ * min is cache and clock behaviour, p99 is a fair worst case for the code,
+ * and the worst column is mostly the host OS preempting it. The brain's
+ * Cortex-A9 (667 MHz, VFPv3) is much slower than a desktop core; play a
+ * slot in MPC mode and read PositionReplay::getWorstUpdateUs() to get the
+ * ratio, scale p99 by it, and pick the
+ * largest N that leaves most of the 20 ms tick to odometry and the rest of
+ * the loop.
+ *
+ * Build & run from the project root:
+ *   g++ -O2 -std=c++20 -Iinclude tools/mpc_horizon_bench.cpp src/mpc_controller.cpp src/run_log.cpp src/path_index.cpp src/spatial_grid.cpp src/resampler.cpp src/idle_trim.cpp src/compact_plan.cpp src/crc32.cpp -o mpc_horizon_bench
+ *   ./mpc_horizon_bench [-i iterations] [recording.bin ...]
+ * With no recordings, 12 synthetic ones are generated.
+ */
+#include "mpc_controller.h"
+#include "replay_sim.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+struct Tracking {
+  double rms = 0;
+  double final = 0;
+};
+
+static Tracking runCorpus(const std::vector<std::vector<WaypointFrame>> &corpus,
+                          MpcController &controller, const SimConfig &config,
+                          std::vector<float> &updateNs) {
+  Tracking tracking;
+  for (const auto &frames : corpus) {
+    SimResult result = simulatePlayback(frames, controller, config);
+    tracking.rms += result.summary.rmsCrossTrack / corpus.size();
+    tracking.final += result.summary.finalPositionError / corpus.size();
+    updateNs.insert(updateNs.end(), result.updateNs.begin(),
+                    result.updateNs.end());
+  }
+  return tracking;
+}
+
+// ~40 KB of fixed matrices, kept off the stack as on the robot
+static MpcController controller;
+
+int main(int argc, char **argv) {
+  uint32_t iterations = MpcGains().iterations;
+  std::vector<std::vector<WaypointFrame>> corpus;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+      iterations = std::max(1, std::atoi(argv[++i]));
+    } else {
+      std::vector<WaypointFrame> frames;
+      if (!loadRecording(argv[i], frames))
+        return 1;
+      corpus.push_back(std::move(frames));
+    }
+  }
+  if (corpus.empty()) {
+    for (uint32_t seed = 1; seed <= 12; seed++)
+      corpus.push_back(synthesizeRecording(seed));
+  }
+
+  SimConfig nominal;
+  SimConfig mismatched;
+  mismatched.maxSpeed = 68;
+  mismatched.timeConstant = 0.12f;
+  mismatched.odomLatencyMs = 20;
+  mismatched.tickMs = 23; // The 20 ms sleep plus the loop's own work
+
+  std::printf("%zu recordings, %u iterations per update\n\n", corpus.size(),
+              iterations);
+  std::printf("   N  lookahead | model match   | mismatched    | update() us\n");
+  std::printf("           ms   |  rms in final |  rms in final |    min   mean    p99  worst\n");
+
+  const uint32_t horizons[] = {2, 5, 10, 15, 20, 25, 30};
+  for (uint32_t horizon : horizons) {
+    MpcGains gains;
+    gains.horizon = horizon;
+    gains.iterations = iterations;
+    controller.setGains(gains);
+
+    std::vector<float> updateNs;
+    Tracking a = runCorpus(corpus, controller, nominal, updateNs);
+    Tracking b = runCorpus(corpus, controller, mismatched, updateNs);
+
+    std::sort(updateNs.begin(), updateNs.end());
+    double mean = 0;
+    for (float ns : updateNs)
+      mean += ns / updateNs.size();
+
+    std::printf("%4u %8u   | %6.2f %6.2f | %6.2f %6.2f | %6.1f %6.1f %6.1f %6.1f\n",
+                horizon, static_cast<uint32_t>(horizon * nominal.tickMs), a.rms, a.final, b.rms, b.final,
+                updateNs.front() / 1000, mean / 1000,
+                updateNs[updateNs.size() * 99 / 100] / 1000,
+                updateNs.back() / 1000);
+  }
+  return 0;
+}
@@ -0,0 +1,188 @@
+/**
+ * Host benchmark for OdomFusion
+ *
+ * Drives a simulated robot along a mixed route (straights, arcs, turns in
+ * place, a shove) and feeds noisy tracking wheel / drive encoder / IMU
+ * readings to two estimators:
+ *   - baseline: tracking wheel + IMU only (what LemLib uses on this robot)
+ *   - fused:    OdomFusion with the default complementary weights
+ * Reports position/heading error over many random seeds and the per-step
+ * cost of the fused update.
+ *
+ * Build & run from the project root:
+ *   g++ -O2 -std=c++20 -Iinclude tools/odom_fusion_bench.cpp src/odom_fusion.cpp -o odom_fusion_bench
+ *   ./odom_fusion_bench [seeds]
+ */
+#include "odom_fusion.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+static constexpr float DT = 0.010f;         // Odom tick (s)
+static constexpr float DURATION = 20.0f;    // Route length (s)
+static constexpr float TRACK_WIDTH = 11.5f; // Inches
+static constexpr float WHEEL_OFFSET = -0.25f;
+
+struct TruePose {
+  double x = 0, y = 0, theta = 0; // Inches, degrees (LemLib convention)
+};
+
+// Commanded body velocity along the route (in/s, deg/s)
+static void routeVelocity(float t, float &v, float &w) {
+  if (t < 3) {
+    v = 60 * std::min(t / 0.5f, 1.0f); // Hard launch
+    w = 0;
+  } else if (t < 6) {
+    v = 45;
+    w = 60; // Sweeping arc
+  } else if (t < 7.5f) {
+    v = 0;
+    w = -180; // Turn in place
+  } else if (t < 11) {
+    v = -40 * std::min((t - 7.5f) / 0.3f, 1.0f); // Reverse
+    w = 0;
+  } else if (t < 15) {
+    v = 50;
+    w = -35 * std::sin(t);
+  } else {
+    v = 30;
+    w = 0;
+  }
+}
+
+struct Result {
+  double finalError = 0;
+  double rmsError = 0;
+  double rmsHeading = 0;
+};
+
+static void simulate(uint32_t seed, Result &baseline, Result &fused) {
+  std::mt19937 rng(seed);
+  std::normal_distribution<float> wheelNoise(0, 0.004f);
+  std::normal_distribution<float> driveNoise(0, 0.01f);
+  std::normal_distribution<float> imuNoise(0, 0.08f);
+  std::uniform_real_distribution<float> uniform(0, 1);
+
+  OdomFusionConfig fusedConfig;
+  fusedConfig.trackWidth = TRACK_WIDTH;
+  fusedConfig.wheelOffset = WHEEL_OFFSET;
+  OdomFusionConfig baseConfig = fusedConfig;
+  baseConfig.imuWeight = 1.0f;
+  baseConfig.wheelWeight = 1.0f;
+  baseConfig.slipThreshold = 1e9f;
+
+  OdomFusion base(baseConfig);
+  OdomFusion fuse(fusedConfig);
+
+  TruePose truth;
+  float wheel = 0, left = 0, right = 0;
+  double imuBias = 0;
+  float prevV = 0;
+  double sumBase = 0, sumFuse = 0, sumBaseH = 0, sumFuseH = 0;
+  int steps = 0;
+
+  for (float t = 0; t < DURATION; t += DT) {
+    float v, w;
+    routeVelocity(t, v, w);
+
+    // Shoved sideways-ish from 12.0-12.4 s: drive spins, robot barely moves
+    bool shoved = t > 12.0f && t < 12.4f;
+    float groundV = shoved ? v * 0.1f : v;
+
+    // Truth (arc integration, LemLib heading convention)
+    double dTheta = w * DT;
+    double dist = groundV * DT;
+    double mid = (truth.theta + dTheta / 2) * M_PI / 180;
+    truth.x += dist * std::sin(mid);
+    truth.y += dist * std::cos(mid);
+    truth.theta += dTheta;
+
+    // Tracking wheel: follows the ground, occasionally bounces off the tiles
+    float dThetaRad = dTheta * M_PI / 180;
+    float wheelDelta = dist + WHEEL_OFFSET * dThetaRad + wheelNoise(rng);
+    if (uniform(rng) < 0.03f)
+      wheelDelta *= 0.6f;
+    wheel += wheelDelta;
+
+    // Drive encoders: slip under hard acceleration and while shoved
+    float accel = std::fabs(v - prevV) / DT;
+    float slip = 1.0f + std::min(accel / 2000.0f, 0.25f);
+    float sideDelta = w * M_PI / 180 * TRACK_WIDTH / 2 * DT;
+    float driveV = v * DT * slip;
+    left += driveV + sideDelta + driveNoise(rng);
+    right += driveV - sideDelta + driveNoise(rng);
+    prevV = v;
+
+    // IMU: noise plus ~1 deg/min drift
+    imuBias += DT / 60.0;
+    float imu = truth.theta + imuBias + imuNoise(rng);
+
+    OdomFusionInput input = {wheel, left, right, imu, DT};
+    base.step(input);
+    fuse.step(input);
+
+    FusedPose b = base.getPose();
+    FusedPose f = fuse.getPose();
+    double eb = std::hypot(b.x - truth.x, b.y - truth.y);
+    double ef = std::hypot(f.x - truth.x, f.y - truth.y);
+    sumBase += eb * eb;
+    sumFuse += ef * ef;
+    sumBaseH += (b.theta - truth.theta) * (b.theta - truth.theta);
+    sumFuseH += (f.theta - truth.theta) * (f.theta - truth.theta);
+    steps++;
+
+    baseline.finalError = eb;
+    fused.finalError = ef;
+  }
+
+  baseline.rmsError = std::sqrt(sumBase / steps);
+  fused.rmsError = std::sqrt(sumFuse / steps);
+  baseline.rmsHeading = std::sqrt(sumBaseH / steps);
+  fused.rmsHeading = std::sqrt(sumFuseH / steps);
+}
+
+int main(int argc, char **argv) {
+  int seeds = argc > 1 ? std::atoi(argv[1]) : 200;
+
+  Result baseSum, fuseSum;
+  for (int s = 0; s < seeds; s++) {
+    Result b, f;
+    simulate(1000 + s, b, f);
+    baseSum.finalError += b.finalError / seeds;
+    baseSum.rmsError += b.rmsError / seeds;
+    baseSum.rmsHeading += b.rmsHeading / seeds;
+    fuseSum.finalError += f.finalError / seeds;
+    fuseSum.rmsError += f.rmsError / seeds;
+    fuseSum.rmsHeading += f.rmsHeading / seeds;
+  }
+
+  std::printf("Odometry over %d seeds (%.0f s route, %.0f ms ticks)\n", seeds,
+              DURATION, DT * 1000);
+  std::printf("%-10s %12s %12s %14s\n", "estimator", "final (in)", "rms (in)",
+              "rms hdg (deg)");
+  std::printf("%-10s %12.3f %12.3f %14.3f\n", "baseline", baseSum.finalError,
+              baseSum.rmsError, baseSum.rmsHeading);
+  std::printf("%-10s %12.3f %12.3f %14.3f\n", "fused", fuseSum.finalError,
+              fuseSum.rmsError, fuseSum.rmsHeading);
+
+  // Per-step cost of the fused update
+  OdomFusion fusion;
+  const int iterations = 2000000;
+  float wheel = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    wheel += 0.3f;
+    OdomFusionInput input = {wheel, wheel * 1.01f, wheel * 0.99f,
+                             static_cast<float>(i % 360), DT};
+    fusion.step(input);
+  }
+  auto end = std::chrono::steady_clock::now();
+  double ns = std::chrono::duration<double, std::nano>(end - start).count() /
+              iterations;
+  std::printf("fused step: %.1f ns/step on host (x: %.1f)\n", ns,
+              fusion.getPose().x);
+  return 0;
+}
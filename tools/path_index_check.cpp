@@ -0,0 +1,101 @@
+/**
+ * Host check for the re-sync path index
+ *
+ * Builds a PathIndex over synthesized plans and compares every query with a
+ * plain scan of the same frame range: random positions around (and well
+ * off) the field, random frame ranges and search radii. nearest() must find
+ * a frame exactly when the scan does, at the same distance, and rejoin()
+ * must agree with the rule documented in path_index.h. Exits non-zero on any
+ * mismatch.
+ *
+ * Build & run from the project root:
+ *   g++ -O2 -std=c++20 -Iinclude tools/path_index_check.cpp src/path_index.cpp src/spatial_grid.cpp src/compact_plan.cpp src/resampler.cpp src/idle_trim.cpp src/crc32.cpp -o path_index_check
+ *   ./path_index_check [queries per plan]
+ */
+#include "path_index.h"
+#include "replay_sim.h"
+#include <cstdlib>
+
+struct CheckResult {
+  size_t queries = 0;
+  size_t found = 0;
+  size_t nearestMismatches = 0;
+  size_t rejoinMismatches = 0;
+};
+
+// Nearest frame in [first, last] within maxDistance, the slow way
+static bool scan(const CompactPlan &plan, float x, float y, size_t first,
+                 size_t last, float maxDistance, float &distance) {
+  bool found = false;
+  distance = maxDistance;
+  for (size_t i = first; i <= last; i++) {
+    GridFrame frame = plan[i];
+    float d = std::hypot(frame.x - x, frame.y - y);
+    if (d <= distance) {
+      distance = d;
+      found = true;
+    }
+  }
+  return found;
+}
+
+static void check(uint32_t seed, size_t queries, CheckResult &result) {
+  std::vector<WaypointFrame> recording = synthesizeRecording(seed, 30);
+  std::vector<GridFrame> grid;
+  resampleToGrid(recording.data(), recording.size(), 10000, 25000, grid);
+  CompactPlan plan;
+  plan.encode(grid, 10000);
+  PathIndex index;
+  index.build(plan);
+
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> field(-200, 200);
+  std::uniform_real_distribution<float> radius(0, 200);
+  for (size_t q = 0; q < queries; q++) {
+    float x = field(rng);
+    float y = field(rng);
+    size_t first = rng() % plan.size();
+    size_t last = std::min(plan.size() - 1, first + rng() % 800);
+    float maxDistance = radius(rng);
+
+    size_t frame;
+    float distance;
+    bool found = index.nearest(x, y, first, last, maxDistance, frame, distance);
+    float expected;
+    bool expectedFound = scan(plan, x, y, first, last, maxDistance, expected);
+    if (found != expectedFound ||
+        (found && (std::fabs(distance - expected) > 1e-4f ||
+                   std::fabs(std::hypot(plan[frame].x - x, plan[frame].y - y) -
+                             distance) > 1e-4f))) {
+      result.nearestMismatches++;
+    }
+
+    // maxDistance doubles as the distance to the clock's target
+    float offPath = radius(rng) / 4;
+    bool rejoin = index.rejoin(x, y, first, last, offPath, maxDistance, frame);
+    float closest;
+    bool any = scan(plan, x, y, first, last, INFINITY, closest);
+    bool expectedRejoin = maxDistance > 2 * offPath && any &&
+                          closest <= maxDistance / 2 && closest > offPath;
+    if (rejoin != expectedRejoin)
+      result.rejoinMismatches++;
+
+    result.found += found;
+    result.queries++;
+  }
+}
+
+int main(int argc, char **argv) {
+  size_t queries = argc > 1 ? std::max(1, std::atoi(argv[1])) : 2000;
+  CheckResult result;
+  for (uint32_t seed = 1; seed <= 10; seed++)
+    check(seed, queries, result);
+
+  std::printf("%zu queries, %zu within range\n", result.queries, result.found);
+  std::printf("nearest() mismatches: %zu\n", result.nearestMismatches);
+  std::printf("rejoin() mismatches:  %zu\n", result.rejoinMismatches);
+
+  bool ok = result.nearestMismatches == 0 && result.rejoinMismatches == 0;
+  std::printf("%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,279 @@
+/**
+ * Playback PD gain tuner
+ *
+ * Searches ReplayGains for the lowest tracking error over a corpus of
+ * recordings, played through the exact playback law (ReplayController)
+ * against the drivetrain model in replay_sim.h:
+ *   1. a coarse grid over all four gains
+ *   2. Nelder-Mead refinement from the best grid point
+ * Every (gains, recording) pair is an independent simulation, spread over
+ * all CPU cores. The result is printed as tuning.cfg lines.
+ *
+ * Cost per recording = RMS cross-track + 0.5 * final position error
+ *                    + 1 in per 100 ms behind schedule (mean)
+ * Gains that clip the motors on more than the saturation budget's share of
+ * ticks are penalised, so the tuner can't win by slamming the drive.
+ *
+ * Build & run from the project root:
+ *   g++ -O2 -std=c++20 -pthread -Iinclude tools/pd_tuner.cpp src/replay_controller.cpp src/run_log.cpp src/path_index.cpp src/spatial_grid.cpp src/resampler.cpp src/idle_trim.cpp src/compact_plan.cpp src/crc32.cpp -o pd_tuner
+ *   ./pd_tuner [-j threads] [-b saturation budget] [recording.bin ...]
+ * With no recordings, 12 synthetic ones are generated.
+ */
+#include "replay_controller.h"
+#include "replay_sim.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+using Params = std::array<float, 4>;
+
+static ReplayGains toGains(const Params &p) {
+  ReplayGains gains;
+  gains.kP_forward = std::max(p[0], 0.0f);
+  gains.kD_forward = std::max(p[1], 0.0f);
+  gains.kP_turn = std::max(p[2], 0.0f);
+  gains.kD_turn = std::max(p[3], 0.0f);
+  return gains;
+}
+
+struct Score {
+  double cost = 0;
+  double rms = 0;
+  double final = 0;
+  double behind = 0;
+  double saturation = 0;
+};
+
+class Evaluator {
+public:
+  Evaluator(const std::vector<std::vector<WaypointFrame>> &corpus,
+            unsigned threads, float saturationBudget)
+      : corpus(corpus), threads(threads), saturationBudget(saturationBudget) {}
+
+  // Score every candidate over the whole corpus, in parallel
+  std::vector<Score> evaluate(const std::vector<Params> &candidates) {
+    size_t jobs = candidates.size() * corpus.size();
+    std::vector<SimResult> results(jobs);
+    std::atomic<size_t> next{0};
+
+    auto worker = [&] {
+      for (size_t job = next++; job < jobs; job = next++) {
+        ReplayController controller(toGains(candidates[job / corpus.size()]));
+        results[job] = simulatePlayback(corpus[job % corpus.size()], controller);
+      }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; i++)
+      pool.emplace_back(worker);
+    worker();
+    for (auto &thread : pool)
+      thread.join();
+    evaluations += jobs;
+
+    std::vector<Score> scores(candidates.size());
+    for (size_t c = 0; c < candidates.size(); c++) {
+      Score &score = scores[c];
+      for (size_t r = 0; r < corpus.size(); r++) {
+        const SimResult &result = results[c * corpus.size() + r];
+        score.rms += result.summary.rmsCrossTrack / corpus.size();
+        score.final += result.summary.finalPositionError / corpus.size();
+        score.behind += result.summary.meanTimeBehind / corpus.size();
+        score.saturation += result.saturation / corpus.size();
+      }
+      score.cost = score.rms + 0.5 * score.final +
+                   std::max(score.behind, 0.0) / 100.0;
+      if (score.saturation > saturationBudget)
+        score.cost += 100.0 * (score.saturation - saturationBudget);
+    }
+    return scores;
+  }
+
+  size_t getEvaluations() const { return evaluations; }
+
+private:
+  const std::vector<std::vector<WaypointFrame>> &corpus;
+  unsigned threads;
+  float saturationBudget;
+  size_t evaluations = 0;
+};
+
+// ==================== Search ====================
+
+static void gridSearch(Evaluator &evaluator, Params &best, Score &bestScore) {
+  const float kPf[] = {2, 3.5f, 5, 7, 10};
+  const float kDf[] = {0, 4, 8, 16, 32};
+  const float kPt[] = {0.8f, 1.2f, 1.7f, 2.5f, 3.5f};
+  const float kDt[] = {0, 5, 10, 14, 20};
+
+  std::vector<Params> candidates;
+  for (float a : kPf)
+    for (float b : kDf)
+      for (float c : kPt)
+        for (float d : kDt)
+          candidates.push_back({a, b, c, d});
+
+  std::vector<Score> scores = evaluator.evaluate(candidates);
+  for (size_t i = 0; i < candidates.size(); i++) {
+    if (scores[i].cost < bestScore.cost) {
+      bestScore = scores[i];
+      best = candidates[i];
+    }
+  }
+}
+
+static Params blend(const Params &a, const Params &b, float t) {
+  Params result;
+  for (size_t i = 0; i < result.size(); i++)
+    result[i] = a[i] + t * (b[i] - a[i]);
+  return result;
+}
+
+// Nelder-Mead. Reflection, expansion and both contractions are evaluated
+// together each iteration (one parallel batch) rather than one by one.
+static void nelderMead(Evaluator &evaluator, Params &best, Score &bestScore,
+                       int iterations) {
+  constexpr size_t N = 4;
+  std::vector<Params> simplex = {best};
+  for (size_t i = 0; i < N; i++) {
+    Params vertex = best;
+    vertex[i] = vertex[i] > 0.1f ? vertex[i] * 1.25f : 1.0f;
+    simplex.push_back(vertex);
+  }
+  std::vector<Score> scores = evaluator.evaluate(simplex);
+
+  for (int iter = 0; iter < iterations; iter++) {
+    // Order best to worst
+    std::vector<size_t> order(simplex.size());
+    for (size_t i = 0; i < order.size(); i++)
+      order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return scores[a].cost < scores[b].cost;
+    });
+    std::vector<Params> sortedSimplex;
+    std::vector<Score> sortedScores;
+    for (size_t i : order) {
+      sortedSimplex.push_back(simplex[i]);
+      sortedScores.push_back(scores[i]);
+    }
+    simplex = sortedSimplex;
+    scores = sortedScores;
+
+    if (scores[N].cost - scores[0].cost < 1e-4)
+      break;
+
+    Params centroid = {};
+    for (size_t i = 0; i < N; i++)
+      for (size_t k = 0; k < N; k++)
+        centroid[k] += simplex[i][k] / N;
+
+    const Params &worst = simplex[N];
+    std::vector<Params> trial = {
+        blend(centroid, worst, -1.0f), // Reflection
+        blend(centroid, worst, -2.0f), // Expansion
+        blend(centroid, worst, -0.5f), // Outside contraction
+        blend(centroid, worst, 0.5f),  // Inside contraction
+    };
+    std::vector<Score> trialScores = evaluator.evaluate(trial);
+
+    const Score &reflected = trialScores[0];
+    if (reflected.cost < scores[0].cost) {
+      size_t pick = trialScores[1].cost < reflected.cost ? 1 : 0;
+      simplex[N] = trial[pick];
+      scores[N] = trialScores[pick];
+    } else if (reflected.cost < scores[N - 1].cost) {
+      simplex[N] = trial[0];
+      scores[N] = reflected;
+    } else {
+      size_t pick = reflected.cost < scores[N].cost ? 2 : 3;
+      if (trialScores[pick].cost < std::min(reflected.cost, scores[N].cost)) {
+        simplex[N] = trial[pick];
+        scores[N] = trialScores[pick];
+      } else {
+        // Shrink towards the best vertex
+        std::vector<Params> shrunk;
+        for (size_t i = 1; i <= N; i++)
+          shrunk.push_back(blend(simplex[0], simplex[i], 0.5f));
+        std::vector<Score> shrunkScores = evaluator.evaluate(shrunk);
+        for (size_t i = 1; i <= N; i++) {
+          simplex[i] = shrunk[i - 1];
+          scores[i] = shrunkScores[i - 1];
+        }
+      }
+    }
+  }
+
+  for (size_t i = 0; i < simplex.size(); i++) {
+    if (scores[i].cost < bestScore.cost) {
+      bestScore = scores[i];
+      best = simplex[i];
+    }
+  }
+}
+
+// ==================== Main ====================
+
+static void printScore(const char *label, const Params &p, const Score &s) {
+  ReplayGains g = toGains(p);
+  std::printf("%-9s kP_f %5.2f kD_f %5.2f kP_t %5.2f kD_t %5.2f | cost %6.3f "
+              "rms %5.2f final %5.2f behind %4.0fms sat %4.1f%%\n",
+              label, g.kP_forward, g.kD_forward, g.kP_turn, g.kD_turn, s.cost,
+              s.rms, s.final, s.behind, s.saturation * 100);
+}
+
+int main(int argc, char **argv) {
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  float saturationBudget = 0.25f;
+  std::vector<std::vector<WaypointFrame>> corpus;
+
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      threads = std::max(1, std::atoi(argv[++i]));
+    } else if (std::strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+      saturationBudget = std::atof(argv[++i]);
+    } else {
+      std::vector<WaypointFrame> frames;
+      if (!loadRecording(argv[i], frames))
+        return 1;
+      if (!frames.empty())
+        corpus.push_back(frames);
+    }
+  }
+  if (corpus.empty()) {
+    for (uint32_t seed = 1; seed <= 12; seed++)
+      corpus.push_back(synthesizeRecording(seed));
+  }
+
+  std::printf("%zu recordings, %u threads, saturation budget %.0f%%\n\n",
+              corpus.size(), threads, saturationBudget * 100);
+  Evaluator evaluator(corpus, threads, saturationBudget);
+  auto start = std::chrono::steady_clock::now();
+
+  ReplayGains defaults;
+  Params current = {defaults.kP_forward, defaults.kD_forward, defaults.kP_turn,
+                    defaults.kD_turn};
+  Score currentScore = evaluator.evaluate({current})[0];
+  printScore("current", current, currentScore);
+
+  Params best = current;
+  Score bestScore = currentScore;
+  gridSearch(evaluator, best, bestScore);
+  printScore("grid", best, bestScore);
+
+  nelderMead(evaluator, best, bestScore, 80);
+  printScore("refined", best, bestScore);
+
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  std::printf("\n%zu simulated runs in %.1f s\n", evaluator.getEvaluations(),
+              seconds);
+
+  ReplayGains g = toGains(best);
+  std::printf("\n# /usd/tuning.cfg\nkP_forward = %.2f\nkD_forward = %.2f\n"
+              "kP_turn = %.2f\nkD_turn = %.2f\n",
+              g.kP_forward, g.kD_forward, g.kP_turn, g.kD_turn);
+  return 0;
+}
@@ -0,0 +1,193 @@
+/**
+ * Host check for the quantized playback plan and capture buffer
+ *
+ * Resamples recordings onto the playback grid, quantizes them with
+ * CompactPlan, decodes every frame and compares it with the full-precision
+ * grid frame. Each recording is also pushed through a FrameStore and read
+ * back, as a save does, and compared with what was recorded. Reports the
+ * worst position/heading/time error and the memory used, and exits non-zero
+ * if any frame is outside the bounds documented in compact_plan.h and
+ * frame_store.h or a power, button, toggle or action didn't survive exactly.
+ *
+ * With no files, synthesized recordings are placed around the field with
+ * headings several turns from zero; their timestamps are jittered and one
+ * has a stall longer than a 16-bit time delta.
+ *
+ * Build & run from the project root:
+ *   g++ -O2 -std=c++20 -Iinclude tools/plan_quantization_check.cpp src/compact_plan.cpp src/frame_store.cpp src/resampler.cpp src/idle_trim.cpp src/crc32.cpp -o plan_quantization_check
+ *   ./plan_quantization_check [recording.bin ...]
+ */
+#include "frame_store.h"
+#include "replay_sim.h"
+
+// Documented bounds, plus float rounding in the decode
+static constexpr float MAX_POSITION_ERROR = 0.005f + 1e-4f;
+static constexpr float MAX_HEADING_ERROR = 0.003f;
+static constexpr uint64_t MAX_TIME_ERROR_US = CAPTURE_TIME_STEP_US / 2;
+
+struct CheckResult {
+  size_t frames = 0;
+  float positionError = 0;
+  float headingError = 0;
+  size_t exactMismatches = 0;
+
+  size_t captureFrames = 0;
+  size_t bridgingFrames = 0;    // Added for gaps over 655 ms
+  float capturePositionError = 0;
+  float captureHeadingError = 0;
+  uint64_t captureTimeError = 0;
+  size_t captureMismatches = 0;
+};
+
+// Store a recording the way recordFrame() does and read it back the way a
+// save does
+static void checkCapture(const std::vector<WaypointFrame> &recording,
+                         CheckResult &result) {
+  FrameStore store;
+  size_t stored = 0;
+  while (stored < recording.size() && store.push_back(recording[stored]))
+    stored++;
+  if (stored < recording.size()) {
+    std::printf("capture buffer full after %zu of %zu frames\n", stored,
+                recording.size());
+  }
+
+  size_t i = 0;
+  for (const WaypointFrame &frame : store) {
+    // Bridging frames come before the frame that ends a long gap
+    if (frame.timestamp + MAX_TIME_ERROR_US < recording[i].timestamp) {
+      result.bridgingFrames++;
+      continue;
+    }
+    const WaypointFrame &source = recording[i++];
+    result.capturePositionError =
+        std::max({result.capturePositionError, std::fabs(frame.x - source.x),
+                  std::fabs(frame.y - source.y)});
+    result.captureHeadingError = std::max(
+        result.captureHeadingError,
+        std::fabs(std::remainder(frame.theta - source.theta, 360.0f)));
+    uint64_t timeError = frame.timestamp > source.timestamp
+                             ? frame.timestamp - source.timestamp
+                             : source.timestamp - frame.timestamp;
+    result.captureTimeError = std::max(result.captureTimeError, timeError);
+    if (frame.intakePower != source.intakePower ||
+        frame.outtakePower != source.outtakePower ||
+        frame.buttons != source.buttons ||
+        frame.hasAction != source.hasAction) {
+      result.captureMismatches++;
+    }
+  }
+  result.captureFrames += i;
+}
+
+static void check(const std::vector<WaypointFrame> &recording,
+                  CheckResult &result) {
+  std::vector<GridFrame> grid;
+  resampleToGrid(recording.data(), recording.size(), 10000, 25000, grid);
+
+  CompactPlan plan;
+  plan.encode(grid, 10000);
+
+  for (size_t i = 0; i < grid.size(); i++) {
+    GridFrame decoded = plan[i];
+    result.positionError =
+        std::max({result.positionError, std::fabs(decoded.x - grid[i].x),
+                  std::fabs(decoded.y - grid[i].y)});
+    result.headingError =
+        std::max(result.headingError,
+                 std::fabs(std::remainder(decoded.theta - grid[i].theta, 360.0f)));
+    if (decoded.intakePower != grid[i].intakePower ||
+        decoded.outtakePower != grid[i].outtakePower ||
+        decoded.toggles != grid[i].toggles ||
+        decoded.hasAction != grid[i].hasAction) {
+      result.exactMismatches++;
+    }
+  }
+  result.frames += grid.size();
+
+  checkCapture(recording, result);
+}
+
+int main(int argc, char **argv) {
+  CheckResult result;
+  size_t recordings = 0;
+
+  if (argc > 1) {
+    for (int i = 1; i < argc; i++) {
+      std::vector<WaypointFrame> frames;
+      if (!loadRecording(argv[i], frames))
+        return 1;
+      check(frames, result);
+      recordings++;
+    }
+  } else {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> field(-60, 60);
+    std::uniform_int_distribution<int> turns(-3, 3);
+    std::uniform_int_distribution<int> jitter(0, 9000);
+    std::uniform_int_distribution<int> power(-127, 127);
+    for (uint32_t seed = 1; seed <= 200; seed++) {
+      std::vector<WaypointFrame> frames = synthesizeRecording(seed);
+      float dx = field(rng);
+      float dy = field(rng);
+      float dTheta = turns(rng) * 360.0f + field(rng);
+      // Late loop iterations, an intake run and one long stall
+      uint64_t delay = 0;
+      uint8_t prevButtons = 0;
+      for (size_t k = 0; k < frames.size(); k++) {
+        WaypointFrame &frame = frames[k];
+        frame.x += dx;
+        frame.y += dy;
+        frame.theta += dTheta;
+        if (seed == 1 && k == frames.size() / 2)
+          delay += 2000000;
+        frame.timestamp += delay + jitter(rng);
+        if (k % 200 < 60) {
+          frame.intakePower = static_cast<int8_t>(power(rng));
+          frame.buttons |= 1 << BTN_R1;
+        }
+        frame.hasAction = isActionFrame(frame.buttons, prevButtons,
+                                        frame.intakePower, frame.outtakePower);
+        prevButtons = frame.buttons;
+      }
+      check(frames, result);
+      recordings++;
+    }
+  }
+
+  std::printf("%zu recordings, %zu plan frames\n", recordings, result.frames);
+  // What CompactPlan::bytes() counts: pose/mechanisms plus derived motion
+  size_t planBytes = sizeof(PlanFrame) + sizeof(PlanMotion);
+  std::printf("memory:  %zu B/frame (%zu pose + %zu motion, was %zu), "
+              "%.1f KB (was %.1f KB)\n",
+              planBytes, sizeof(PlanFrame), sizeof(PlanMotion),
+              sizeof(GridFrame), result.frames * planBytes / 1024.0,
+              result.frames * sizeof(GridFrame) / 1024.0);
+  std::printf("max position error: %.5f in (bound %.3f)\n", result.positionError,
+              MAX_POSITION_ERROR);
+  std::printf("max heading error:  %.5f deg (bound %.3f)\n", result.headingError,
+              MAX_HEADING_ERROR);
+  std::printf("power/toggle/action mismatches: %zu\n", result.exactMismatches);
+
+  std::printf("\ncapture: %zu frames (+%zu bridging), %zu B/frame (was %zu)\n",
+              result.captureFrames, result.bridgingFrames, sizeof(CaptureFrame),
+              sizeof(WaypointFrame));
+  std::printf("max position error: %.5f in (bound %.3f)\n",
+              result.capturePositionError, MAX_POSITION_ERROR);
+  std::printf("max heading error:  %.5f deg (bound %.3f)\n",
+              result.captureHeadingError, MAX_HEADING_ERROR);
+  std::printf("max time error:     %llu us (bound %llu)\n",
+              static_cast<unsigned long long>(result.captureTimeError),
+              static_cast<unsigned long long>(MAX_TIME_ERROR_US));
+  std::printf("power/button/action mismatches: %zu\n", result.captureMismatches);
+
+  bool ok = result.positionError <= MAX_POSITION_ERROR &&
+            result.headingError <= MAX_HEADING_ERROR &&
+            result.exactMismatches == 0 &&
+            result.capturePositionError <= MAX_POSITION_ERROR &&
+            result.captureHeadingError <= MAX_HEADING_ERROR &&
+            result.captureTimeError <= MAX_TIME_ERROR_US &&
+            result.captureMismatches == 0;
+  std::printf("%s\n", ok ? "PASS" : "FAIL");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,332 @@
+#pragma once
+/**
+ * Host-side playback simulator
+ *
+ * A differential drive model (first-order motor response, velocity
+ * saturation, delayed odometry) that PositionReplay's tracking law can be
+ * run against off the robot, plus helpers to read recordings from disk and
+ * to synthesize realistic ones. Shared by the tools in this directory.
+ *
+ * Angles follow LemLib's convention: degrees, 0 = +Y, clockwise positive.
+ */
+#include "compact_plan.h"
+#include "crc32.h"
+#include "idle_trim.h"
+#include "path_index.h"
+#include "recording_format.h"
+#include "replay_controller.h"
+#include "resampler.h"
+#include "run_log.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Drivetrain model - defaults match robot_config.cpp (450 rpm, 3.25" omnis)
+struct SimConfig {
+  float maxSpeed = 76.6f;     // in/s at full power
+  float trackWidth = 11.5f;   // in
+  float timeConstant = 0.08f; // s, motor + chassis response
+  float tickMs = 20;          // Playback loop period
+  float odomLatencyMs = 10;   // Age of the pose the controller sees
+  uint32_t gridPeriodMs = 10; // Playback grid (PositionReplay::setGridPeriod())
+  bool trimIdle = true;       // Shorten pauses (PositionReplay::setIdleTrim())
+  float startOffsetX = 0;     // Robot placed this far from the recorded start
+  float startOffsetY = 0;     // (inches / degrees)
+  float startOffsetTheta = 0;
+  float resyncDistance = 12;  // PositionReplay::setResyncDistance() (0 = off)
+};
+
+struct SimPose {
+  float x = 0, y = 0, theta = 0;
+};
+
+class DriveSim {
+public:
+  SimPose pose;
+  float leftSpeed = 0; // in/s
+  float rightSpeed = 0;
+
+  explicit DriveSim(const SimConfig &config) : config(config) {}
+
+  // Advance by dt seconds with the given motor powers (-127..127)
+  void step(float leftPower, float rightPower, float dt) {
+    float alpha = 1.0f - std::exp(-dt / config.timeConstant);
+    leftSpeed += (std::clamp(leftPower, -127.0f, 127.0f) / 127.0f *
+                      config.maxSpeed -
+                  leftSpeed) *
+                 alpha;
+    rightSpeed += (std::clamp(rightPower, -127.0f, 127.0f) / 127.0f *
+                       config.maxSpeed -
+                   rightSpeed) *
+                  alpha;
+
+    float v = (leftSpeed + rightSpeed) * 0.5f;
+    float w = (leftSpeed - rightSpeed) / config.trackWidth; // rad/s, clockwise
+    float mid = pose.theta * M_PI / 180.0f + w * dt * 0.5f;
+    pose.x += v * dt * std::sin(mid);
+    pose.y += v * dt * std::cos(mid);
+    pose.theta += w * dt * 180.0f / M_PI;
+  }
+
+private:
+  SimConfig config;
+};
+
+// ==================== Recordings ====================
+
+// Same checks as PositionReplay::readRecordingFile(), minus the transforms.
+// `checksum` receives the recording's CRC-32 (what run logs refer to).
+inline bool loadRecording(const char *path, std::vector<WaypointFrame> &frames,
+                          uint32_t *checksum = nullptr) {
+  FILE *file = fopen(path, "rb");
+  if (!file) {
+    std::fprintf(stderr, "can't open %s\n", path);
+    return false;
+  }
+
+  uint32_t header[3];
+  if (fread(header, sizeof(header), 1, file) != 1 ||
+      header[0] != RECORDING_MAGIC || header[1] > RECORDING_VERSION) {
+    std::fprintf(stderr, "%s is not a recording\n", path);
+    fclose(file);
+    return false;
+  }
+  uint32_t crc = crc32(header, sizeof(header));
+
+  if (header[1] >= 3) {
+    RecordingStartInfo start;
+    if (fread(&start, sizeof(start), 1, file) != 1) {
+      fclose(file);
+      return false;
+    }
+    crc = crc32(&start, sizeof(start), crc);
+  }
+
+  frames.resize(header[2]);
+  if (fread(frames.data(), sizeof(WaypointFrame), header[2], file) !=
+      header[2]) {
+    std::fprintf(stderr, "%s is truncated\n", path);
+    fclose(file);
+    return false;
+  }
+  crc = crc32(frames.data(), header[2] * sizeof(WaypointFrame), crc);
+
+  uint32_t storedCrc;
+  if (header[1] >= 2 && (fread(&storedCrc, sizeof(storedCrc), 1, file) != 1 ||
+                         storedCrc != crc)) {
+    std::fprintf(stderr, "%s failed its CRC check\n", path);
+    fclose(file);
+    return false;
+  }
+
+  fclose(file);
+  if (checksum)
+    *checksum = crc;
+  return true;
+}
+
+// Drive the model with a random but driver-like stick script (straights,
+// arcs, turns in place, reversals, mechanism presses) and record it every
+// 25 ms the way PositionReplay::recordFrame() does
+inline std::vector<WaypointFrame> synthesizeRecording(uint32_t seed,
+                                                      float seconds = 15,
+                                                      const SimConfig &config =
+                                                          SimConfig()) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> uniform(0, 1);
+  DriveSim sim(config);
+
+  std::vector<WaypointFrame> frames;
+  float forward = 0, turn = 0, targetForward = 0, targetTurn = 0;
+  float segmentEnd = 0;
+  const uint64_t stepUs = 5000;
+  const uint64_t intervalUs = 25000;
+  const float dt = stepUs / 1e6f;
+
+  for (uint64_t us = 0; us < seconds * 1e6f; us += stepUs) {
+    float t = us / 1e6f;
+    if (t >= segmentEnd) {
+      float kind = uniform(rng);
+      if (kind < 0.4f) { // Straight
+        targetForward = (uniform(rng) < 0.2f ? -1 : 1) * (60 + 67 * uniform(rng));
+        targetTurn = 0;
+      } else if (kind < 0.8f) { // Arc
+        targetForward = 50 + 60 * uniform(rng);
+        targetTurn = (uniform(rng) - 0.5f) * 80;
+      } else { // Turn in place
+        targetForward = 0;
+        targetTurn = (uniform(rng) < 0.5f ? -1 : 1) * (50 + 40 * uniform(rng));
+      }
+      segmentEnd = t + 0.6f + 1.4f * uniform(rng);
+    }
+
+    // Drivers don't slam the sticks
+    forward += (targetForward - forward) * 0.04f;
+    turn += (targetTurn - turn) * 0.04f;
+    sim.step(forward + turn, forward - turn, dt);
+
+    if (us % intervalUs == 0) {
+      WaypointFrame frame = {};
+      frame.x = sim.pose.x;
+      frame.y = sim.pose.y;
+      frame.theta = sim.pose.theta;
+      frame.timestamp = us;
+      frame.hasAction = uniform(rng) < 0.004f;
+      if (frame.hasAction)
+        frame.buttons = 1 << BTN_X;
+      frames.push_back(frame);
+    }
+  }
+  return frames;
+}
+
+// ==================== Playback ====================
+
+struct SimResult {
+  RunSummary summary = {};
+  float saturation = 0;          // Fraction of ticks where either side was clipped
+  std::vector<float> updateNs;   // Host time of each controller update
+  uint32_t resyncs = 0;          // Clock re-syncs (PositionReplay::getResyncCount())
+};
+
+// PositionReplay::findFrameIndexAtTime()
+inline size_t frameIndexAtTime(const CompactPlan &plan,
+                               uint32_t periodUs, uint64_t elapsedMicros) {
+  size_t idx = (elapsedMicros + periodUs - 1) / periodUs;
+  return std::min(idx, plan.size() - 1);
+}
+
+// Run a recording through `controller` (anything with reset() and an
+// update(TrackingTarget, x, y, theta) or, for laws that look ahead,
+// update(plan, frame, x, y, theta, periodMs) returning a DriveCommand) the
+// way PositionReplay::playback() does, starting on the recording's first
+// frame (plus the configured start offset) and re-syncing like it. The run
+// is scored with RunLog exactly like on the robot; pass `log` to keep the
+// samples.
+template <typename Controller>
+SimResult simulatePlayback(const std::vector<WaypointFrame> &frames,
+                           Controller &controller,
+                           const SimConfig &config = SimConfig(),
+                           RunLog *log = nullptr) {
+  SimResult result;
+  if (frames.empty())
+    return result;
+
+  // Played from the uniform grid, as on the robot
+  uint32_t periodUs = config.gridPeriodMs * 1000;
+  std::vector<GridFrame> grid;
+  resampleToGrid(frames.data(), frames.size(), periodUs, 25000, grid);
+  if (config.trimIdle)
+    trimIdle(grid, periodUs);
+  CompactPlan plan;
+  plan.encode(grid, periodUs);
+
+  RunLog localLog;
+  RunLog &runLog = log ? *log : localLog;
+  runLog.begin(0);
+
+  DriveSim sim(config);
+  sim.pose = {frames[0].x + config.startOffsetX,
+              frames[0].y + config.startOffsetY,
+              frames[0].theta + config.startOffsetTheta};
+  controller.reset();
+
+  // Pose history for odometry latency
+  const float substep = 0.001f;
+  size_t delaySteps = std::lround(config.odomLatencyMs / 1000.0f / substep);
+  size_t tickSteps = std::max(1L, std::lround(config.tickMs / 1000.0f / substep));
+  std::vector<SimPose> history(delaySteps + 1, sim.pose);
+  size_t head = 0;
+
+  uint64_t tickUs = static_cast<uint64_t>(config.tickMs * 1000);
+  uint64_t totalDuration = static_cast<uint64_t>(plan.size() - 1) * periodUs;
+  size_t saturatedTicks = 0;
+  size_t ticks = 0;
+  result.updateNs.reserve(totalDuration / tickUs + 1);
+
+  // Re-sync state, as in PositionReplay::runPlayback()
+  PathIndex pathIndex;
+  if (config.resyncDistance > 0)
+    pathIndex.build(plan);
+  int64_t timeOffset = 0;
+  uint64_t nextResync = 0;
+  size_t back = 3000000 / periodUs;  // RESYNC_BACK_MS
+  size_t ahead = 1000000 / periodUs; // RESYNC_AHEAD_MS
+
+  uint64_t wallElapsed = 0;
+  for (;; wallElapsed += tickUs) {
+    uint64_t elapsed = static_cast<uint64_t>(std::max<int64_t>(
+        static_cast<int64_t>(wallElapsed) + timeOffset, 0));
+    if (elapsed >= totalDuration)
+      break;
+    size_t idx = frameIndexAtTime(plan, periodUs, elapsed);
+    GridFrame target = plan[idx];
+    const SimPose &seen = history[(head + 1) % history.size()]; // Oldest
+
+    float deviation = std::hypot(target.x - seen.x, target.y - seen.y);
+    uint8_t flags = 0;
+    if (config.resyncDistance > 0 && deviation > config.resyncDistance &&
+        wallElapsed >= nextResync) {
+      size_t nearest;
+      if (pathIndex.rejoin(seen.x, seen.y, idx > back ? idx - back : 0,
+                           std::min(idx + ahead, plan.size() - 1),
+                           config.resyncDistance, deviation, nearest)) {
+        timeOffset += static_cast<int64_t>(nearest) * periodUs -
+                      static_cast<int64_t>(elapsed);
+        idx = nearest;
+        target = plan[idx];
+        if constexpr (requires { controller.restart(); })
+          controller.restart();
+        else
+          controller.reset();
+        result.resyncs++;
+        flags |= RUN_FLAG_RESYNC;
+      }
+      nextResync = wallElapsed + 500000; // RESYNC_COOLDOWN_MS
+    }
+
+    runLog.add({static_cast<uint32_t>(wallElapsed / 1000),
+                static_cast<uint32_t>(idx * periodUs / 1000),
+                static_cast<uint16_t>(idx), flags, 0, sim.pose.x, sim.pose.y,
+                sim.pose.theta, target.x, target.y});
+
+    auto start = std::chrono::steady_clock::now();
+    DriveCommand command;
+    if constexpr (requires {
+                    controller.update(plan, idx, 0.0f, 0.0f, 0.0f, 0.0f);
+                  }) {
+      command = controller.update(plan, idx, seen.x, seen.y, seen.theta,
+                                  config.tickMs);
+    } else {
+      TrackingTarget tracking = {target.x, target.y, target.theta,
+                                 plan.speed(idx), plan.turnRate(idx)};
+      command = controller.update(tracking, seen.x, seen.y, seen.theta);
+    }
+    result.updateNs.push_back(std::chrono::duration<float, std::nano>(
+                                  std::chrono::steady_clock::now() - start)
+                                  .count());
+    float left = command.forward + command.turn;
+    float right = command.forward - command.turn;
+    if (std::fabs(left) > 127 || std::fabs(right) > 127)
+      saturatedTicks++;
+    ticks++;
+
+    for (size_t step = 0; step < tickSteps; step++) {
+      sim.step(left, right, substep);
+      head = (head + 1) % history.size();
+      history[head] = sim.pose;
+    }
+  }
+
+  GridFrame last = plan.back();
+  runLog.add({static_cast<uint32_t>(wallElapsed / 1000),
+              static_cast<uint32_t>(totalDuration / 1000),
+              static_cast<uint16_t>(plan.size() - 1), 0, 0, sim.pose.x,
+              sim.pose.y, sim.pose.theta, last.x, last.y});
+  result.summary = runLog.finish(last.x, last.y, last.theta);
+  result.saturation = ticks > 0 ? static_cast<float>(saturatedTicks) / ticks : 0;
+  return result;
+}
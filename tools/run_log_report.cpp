@@ -0,0 +1,164 @@
+/**
+ * Host report for playback run logs
+ *
+ * Lines a run log ("<recording>.run", written after every playback) up
+ * with the recording it was played from and prints a per-segment error
+ * table, so it's easy to see where the replay loses accuracy. Segments
+ * break at every recorded mechanism action and at least every
+ * `segment seconds` (default 2).
+ *
+ * Times are playback times: the recording is resampled and idle-trimmed
+ * the way the brain does it, using the tuning file if one is given (the
+ * defaults otherwise).
+ *
+ * Build & run from the project root (copy the files off the SD card first):
+ *   g++ -O2 -std=c++20 -Iinclude tools/run_log_report.cpp src/run_log.cpp src/resampler.cpp src/idle_trim.cpp src/compact_plan.cpp src/tuning_config.cpp src/replay_controller.cpp src/crc32.cpp -o run_log_report
+ *   ./run_log_report position_recording.bin position_recording.run [segment seconds] [tuning.cfg]
+ */
+#include "idle_trim.h"
+#include "replay_sim.h"
+#include "tuning_config.h"
+#include <cstdlib>
+
+struct Recording {
+  std::vector<WaypointFrame> frames;
+  std::vector<GridFrame> plan;
+  uint32_t periodUs = 10000;
+  uint32_t checksum = 0;
+};
+
+struct Segment {
+  uint32_t startMs = 0;
+  uint32_t endMs = 0;
+  bool action = false;      // Segment starts at a mechanism action
+  size_t samples = 0;
+  double sumSquares = 0;
+  float maxCrossTrack = 0;
+  double sumBehind = 0;
+};
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    std::fprintf(stderr,
+                 "usage: %s recording.bin run.run [segment seconds] "
+                 "[tuning.cfg]\n",
+                 argv[0]);
+    return 1;
+  }
+  float segmentSeconds = argc > 3 ? std::atof(argv[3]) : 2.0f;
+  uint32_t segmentMs = segmentSeconds > 0 ? segmentSeconds * 1000 : 2000;
+
+  Recording recording;
+  if (!loadRecording(argv[1], recording.frames, &recording.checksum))
+    return 1;
+
+  TuningConfig config;
+  if (argc > 4) {
+    tuningFile.setPath(argv[4]);
+    if (!tuningFile.load()) {
+      std::fprintf(stderr, "can't read %s\n", argv[4]);
+      return 1;
+    }
+    config = tuningFile.get();
+  }
+  recording.periodUs = std::max<uint32_t>(config.gridPeriod, 1) * 1000;
+  resampleToGrid(recording.frames.data(), recording.frames.size(),
+                 recording.periodUs, config.recordingInterval * 1000,
+                 recording.plan);
+  if (config.trimIdle) {
+    IdleTrimConfig trim;
+    trim.minDwellMs = config.idleDwell;
+    trim.maxSpeed = config.idleSpeed;
+    IdleTrimReport trimmed = trimIdle(recording.plan, recording.periodUs, trim);
+    if (trimmed.intervals > 0) {
+      std::printf("idle trim: %u pauses, %.2f s saved\n", trimmed.intervals,
+                  trimmed.secondsSaved);
+    }
+  }
+
+  RunLog log;
+  if (!log.load(argv[2])) {
+    std::fprintf(stderr, "%s is not a valid run log\n", argv[2]);
+    return 1;
+  }
+  if (log.getRecordingChecksum() != recording.checksum) {
+    std::fprintf(stderr,
+                 "warning: run was played from a different recording "
+                 "(%08x, this one is %08x)\n",
+                 log.getRecordingChecksum(), recording.checksum);
+  }
+
+  // Segment boundaries in playback time: every action frame, then split
+  // anything longer than segmentMs
+  std::vector<Segment> segments;
+  Segment current;
+  for (size_t k = 0; k < recording.plan.size(); k++) {
+    const GridFrame &frame = recording.plan[k];
+    uint32_t ms = k * recording.periodUs / 1000;
+    if ((frame.hasAction && ms > current.startMs) ||
+        ms - current.startMs >= segmentMs) {
+      current.endMs = ms;
+      segments.push_back(current);
+      current = Segment();
+      current.startMs = ms;
+      current.action = frame.hasAction;
+    }
+  }
+  current.endMs = recording.plan.empty() ? 0
+                                         : (recording.plan.size() - 1) *
+                                               recording.periodUs / 1000;
+  segments.push_back(current);
+
+  // Bin every sample by the playback time of the frame it was chasing
+  size_t segment = 0;
+  for (size_t i = 0; i < log.size(); i++) {
+    const RunSample &sample = log[i];
+    uint32_t ms = sample.targetMs;
+    while (segment + 1 < segments.size() && ms >= segments[segment].endMs)
+      segment++;
+    while (segment > 0 && ms < segments[segment].startMs)
+      segment--;
+
+    SampleError error = log.measure(i);
+    Segment &bin = segments[segment];
+    bin.samples++;
+    bin.sumSquares += error.crossTrack * error.crossTrack;
+    bin.maxCrossTrack = std::max(bin.maxCrossTrack, error.crossTrack);
+    bin.sumBehind += error.timeBehind;
+  }
+
+  const RunSummary &summary = log.getSummary();
+  std::printf("run: %u samples over %.2f s (recording %zu frames, %.2f s)\n",
+              summary.sampleCount, summary.durationMs / 1000.0,
+              recording.frames.size(), current.endMs / 1000.0);
+  std::printf("rms cross-track %.2f in, max %.2f in, final %.2f in / %.1f "
+              "deg, mean behind %.0f ms (max %.0f ms)\n\n",
+              summary.rmsCrossTrack, summary.maxCrossTrack,
+              summary.finalPositionError, summary.finalHeadingError,
+              summary.meanTimeBehind, summary.maxTimeBehind);
+
+  std::printf("%-15s %-6s %7s %10s %10s %12s\n", "segment (s)", "start",
+              "samples", "rms (in)", "max (in)", "behind (ms)");
+  size_t worst = 0;
+  float worstRms = -1;
+  for (size_t i = 0; i < segments.size(); i++) {
+    const Segment &s = segments[i];
+    if (s.samples == 0)
+      continue;
+    float rms = std::sqrt(s.sumSquares / s.samples);
+    std::printf("%6.2f - %6.2f  %-6s %7zu %10.2f %10.2f %12.0f\n",
+                s.startMs / 1000.0, s.endMs / 1000.0,
+                s.action ? "action" : "", s.samples, rms, s.maxCrossTrack,
+                s.sumBehind / s.samples);
+    if (rms > worstRms) {
+      worstRms = rms;
+      worst = i;
+    }
+  }
+  if (worstRms >= 0) {
+    std::printf("\nworst segment: %.2f - %.2f s (rms %.2f in)\n",
+                segments[worst].startMs / 1000.0,
+                segments[worst].endMs / 1000.0, worstRms);
+  }
+  return 0;
+}